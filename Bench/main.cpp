@@ -0,0 +1,618 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+
+#include <SFML/System/Clock.hpp>
+
+#include "Console.hpp"
+#include "BitmapFont.hpp"
+#include "BitmapText.hpp"
+
+#ifdef DBR_CNSL_RCON
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "RemoteConsole.hpp"
+#endif
+
+#ifdef DBR_CNSL_TERMINAL
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "TerminalConsole.hpp"
+#endif
+
+// generated from res/font12.png by FontCompiler at build time
+#if __has_include("Font12.hpp")
+#include "Font12.hpp"
+#define HAS_EMBEDDED_FONT12
+#endif
+
+// runs without a window or GL context, so it can run on build servers
+// run from the repository root, so res/ can be found
+
+namespace
+{
+	struct Case
+	{
+		std::string name;
+		sf::String text;
+	};
+
+	sf::String makeText(std::size_t lineLength, std::size_t lines)
+	{
+		std::string line;
+
+		for(auto i = 0u; i < lineLength; ++i)
+			line += static_cast<char>('!' + i % 94);
+
+		std::string text;
+
+		for(auto i = 0u; i < lines; ++i)
+			text += line + '\n';
+
+		return text;
+	}
+
+	// the byte at a time hash std::hash<sf::String> used before, to compare against
+	std::size_t fnv1a(const sf::String& s)
+	{
+		constexpr std::uint64_t prime = (std::uint64_t{2} << 39) + (2u << 7) + 0xb3u;
+		constexpr std::uint64_t offset = 14695981039346656037u;
+
+		auto* ptr = reinterpret_cast<const std::uint8_t*>(s.getData());
+		auto* end = ptr + s.getSize() * sizeof(sf::Uint32);
+
+		std::uint64_t val = offset;
+
+		for(; ptr != end; ++ptr)
+		{
+			val ^= *ptr;
+			val *= prime;
+		}
+
+		return static_cast<std::size_t>(val);
+	}
+
+	// calls work repeatedly for at least minTime, and prints the rate of whatever work returns a count of
+	void measure(const std::string& name, const std::string& unit, sf::Time minTime, const std::function<std::size_t()>& work)
+	{
+		std::size_t count = 0;
+
+		sf::Clock clock;
+
+		while(clock.getElapsedTime() < minTime)
+			count += work();
+
+		auto elapsed = clock.getElapsedTime().asSeconds();
+
+		std::cout << std::left << std::setw(32) << name
+			<< std::right << std::setw(14) << std::fixed << std::setprecision(0) << count / elapsed << ' ' << unit << "/s\n";
+	}
+
+	// prints the memory used by a console of size with rows of scrollback, next to what
+	// storing 4 sf::Vertex per scrollback cell would take
+	void footprint(const dbr::sfml::BitmapFont& font, sf::Vector2u size, std::size_t rows)
+	{
+		dbr::cnsl::Console console{size, {1.f, 1.f}, "$ ", font};
+		console.setScrollbackSize(rows);
+
+		auto used = console.getMemoryUsage();
+		auto vertices = console.getScrollbackSize() * size.x * 4 * sizeof(sf::Vertex);
+
+		std::cout << std::right << std::setw(5) << size.x << 'x' << std::left << std::setw(5) << size.y
+			<< std::right << std::setw(7) << console.getScrollbackSize() << " rows"
+			<< std::setw(12) << used / 1024 << " KiB"
+			<< std::setw(12) << vertices / 1024 << " KiB as vertices\n";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	using namespace dbr;
+
+	const auto minTime = sf::seconds(1.f);
+
+	sfml::BitmapFont monoFont;
+	if(!monoFont.loadFromFile("res/font12.png", {12, 12}))
+		return 1;
+
+	/* addString */
+
+	cnsl::ConsoleCore console{{200, 60}, "$ "};
+
+	// measures the grid itself, so nothing is collapsed or dropped
+	auto& flood = console.getFlood();
+	flood.charLimit = static_cast<std::size_t>(-1);
+	flood.lineLimit = static_cast<std::size_t>(-1);
+	flood.coalesce = false;
+
+	std::vector<Case> cases =
+	{
+		{"addString: short lines", makeText(20, 64)},
+		{"addString: full rows", makeText(199, 16)},
+		{"addString: wrapping", makeText(1000, 4)},
+		{"addString: spaces", sf::String{std::string(4096, ' ')}},
+	};
+
+	for(auto& c : cases)
+	{
+		measure(c.name, "chars", minTime, [&]()
+		{
+			console << c.text;
+			return c.text.getSize();
+		});
+	}
+
+	/* FloodControl */
+
+	// a runaway logger, printing 10000 lines a frame
+	cnsl::ConsoleCore flooded{{200, 60}, "$ "};
+
+	const sf::String repeated = "disk full: could not write /var/log/something.log\n";
+
+	measure("flood: repeated line", "lines", minTime, [&]()
+	{
+		for(auto i = 0u; i < 10000; ++i)
+			flooded << repeated;
+
+		flooded.update();
+		return 10000;
+	});
+
+	measure("flood: distinct lines", "lines", minTime, [&]()
+	{
+		for(auto i = 0u; i < 10000; ++i)
+			flooded << "line " << i << '\n';
+
+		flooded.update();
+		return 10000;
+	});
+
+	/* TextGrid::resize */
+
+	// dragging a window edge, rewrapping all the scrollback's output each time
+	for(std::size_t rows : {500u, 100000u})
+	{
+		cnsl::TextGrid resized{{200, 60}, rows};
+		resized.write(makeText(300, rows * 2 / 5));
+
+		unsigned int width = 200;
+
+		measure("resize: " + std::to_string(rows) + " rows", "resizes", minTime, [&]()
+		{
+			width = width == 200 ? 199 : 200;
+			resized.resize({width, 60});
+			return 1;
+		});
+	}
+
+	/* run */
+
+	std::size_t calls = 0;
+	console.addCommand("echo", [&](const cnsl::Args& args) { calls += args.size(); });
+
+	const sf::String entry = "echo first second third";
+
+	measure("run: command", "entries", minTime, [&]()
+	{
+		console.run(entry);
+		return 1;
+	});
+
+	console.addCommand("echoView", [&](cnsl::ArgsView args) { calls += args.size(); });
+
+	const sf::String viewEntry = "echoView first second third";
+
+	measure("run: ArgsView command", "entries", minTime, [&]()
+	{
+		console.run(viewEntry);
+		return 1;
+	});
+
+	// the same arguments, parsed by the command itself, and by addCommand()'s parameter types
+	console.addCommand("parse", [&](const cnsl::Args& args)
+	{
+		calls += std::stoi(args[1].toAnsiString()) + static_cast<int>(std::stof(args[2].toAnsiString())) + args[3].getSize();
+	});
+
+	const sf::String parseEntry = "parse 42 3.5 third";
+
+	measure("run: command, parsing arguments", "entries", minTime, [&]()
+	{
+		console.run(parseEntry);
+		return 1;
+	});
+
+	console.addCommand("typed", [&](int i, float f, cnsl::StringView str)
+	{
+		calls += i + static_cast<int>(f) + str.size();
+	});
+
+	const sf::String typedEntry = "typed 42 3.5 third";
+
+	measure("run: typed command", "entries", minTime, [&]()
+	{
+		console.run(typedEntry);
+		return 1;
+	});
+
+	measure("run: unknown command", "entries", minTime, [&]()
+	{
+		console.run("nope first second third");
+		return 1;
+	});
+
+	/* exec */
+
+	// a replayed session, run as a script, and a line at a time
+	const char* scriptFile = "bench_script.txt";
+
+	{
+		std::ofstream script{scriptFile};
+
+		for(auto i = 0; i < 10000; ++i)
+			script << "echoView first second " << i << '\n';
+	}
+
+	cnsl::ConsoleCore::ExecStats execStats;
+
+	measure("exec: script", "lines", minTime, [&]()
+	{
+		console.exec(scriptFile, execStats);
+		return execStats.lines;
+	});
+
+	measure("exec: getline, run()", "lines", minTime, [&]()
+	{
+		std::ifstream script{scriptFile};
+		std::string line;
+		std::size_t lines = 0;
+
+		while(std::getline(script, line))
+		{
+			console.run(sf::String::fromUtf8(line.begin(), line.end()));
+			++lines;
+		}
+
+		return lines;
+	});
+
+	std::remove(scriptFile);
+
+#ifdef DBR_CNSL_RCON
+	/* RemoteConsole */
+
+	// clients all sending a command at once, and waiting for its output. Over a Unix socket, as TCP on loopback
+	// measures the kernel more than the console
+	{
+		const char* socketPath = "bench_rcon.sock";
+		const std::size_t clientCount = 256;
+
+		cnsl::RemoteConsole rcon{console};
+		rcon.listenUnix(socketPath);
+
+		console.addCommand("ping", [&]() { console << sf::String{"pong\n"}; });
+
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		std::copy(socketPath, socketPath + std::strlen(socketPath), address.sun_path);
+
+		std::vector<int> clients;
+
+		for(auto i = 0u; i < clientCount; ++i)
+		{
+			int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+			clients.push_back(fd);
+		}
+
+		measure("rcon: " + std::to_string(clientCount) + " clients", "entries", minTime, [&]()
+		{
+			for(auto fd : clients)
+				send(fd, "ping\n", 5, 0);
+
+			std::size_t answered = 0;
+			char reply[64];
+
+			while(answered < clientCount)
+			{
+				rcon.update();
+
+				for(auto fd : clients)
+					answered += recv(fd, reply, sizeof(reply), MSG_DONTWAIT) > 0;
+			}
+
+			return clientCount;
+		});
+
+		for(auto fd : clients)
+			close(fd);
+	}
+#endif
+
+#ifdef DBR_CNSL_TERMINAL
+	/* TerminalConsole */
+
+	// a frame with a new line of output only writes that line, as the rows above scroll with the terminal,
+	// next to redrawing every cell. Written to /dev/null, so this measures the console rather than a terminal
+	{
+		int devNull = open("/dev/null", O_RDWR);
+
+		cnsl::TerminalConsole terminal{"$ ", devNull, devNull};
+		terminal.setSize({200, 60});
+
+		// as for addString, so nothing is collapsed or dropped
+		auto& terminalFlood = terminal.getFlood();
+		terminalFlood.charLimit = static_cast<std::size_t>(-1);
+		terminalFlood.lineLimit = static_cast<std::size_t>(-1);
+		terminalFlood.coalesce = false;
+
+		auto line = makeText(150, 1);
+
+		for(auto redraw : {false, true})
+		{
+			std::size_t bytes = 0;
+			std::size_t frames = 0;
+
+			measure(redraw ? "terminal: frame, redrawn" : "terminal: frame, a new line", "frames", minTime, [&]()
+			{
+				if(redraw)
+					terminal.invalidate();
+
+				terminal.post(line);
+				terminal.update();
+				terminal.draw();
+
+				bytes += terminal.getFrameBytes();
+				++frames;
+
+				return std::size_t{1};
+			});
+
+			std::cout << std::setw(46) << bytes / frames << " bytes/frame\n";
+		}
+
+		close(devNull);
+	}
+#endif
+
+	/* CVar */
+
+	auto scale = console.addCVar("scale", 1.f);
+
+	// what a game thread pays per read in a hot loop
+	measure("cvar: read", "reads", minTime, [&]()
+	{
+		float sum = 0;
+
+		for(auto i = 0; i < 1000; ++i)
+			sum += scale.get();
+
+		calls += static_cast<std::size_t>(sum);
+		return 1000;
+	});
+
+	const sf::String setEntries[] = {"scale 2.5", "scale 0.5"};
+	std::size_t setIndex = 0;
+
+	measure("cvar: set by name", "entries", minTime, [&]()
+	{
+		console.run(setEntries[setIndex++ % 2]);
+		return 1;
+	});
+
+	/* LineEditor */
+
+	// types into the middle of a long, wrapped entry, then deletes it again
+	cnsl::ConsoleCore editing{{80, 25}, "$ "};
+	const std::size_t entryLength = 600;
+
+	for(auto i = 0u; i < entryLength; ++i)
+		editing.input(static_cast<sf::Uint32>('a' + i % 26));
+
+	editing.input(cnsl::ConsoleCore::Key::Home);
+
+	for(auto i = 0u; i < entryLength / 2; ++i)
+		editing.input(cnsl::ConsoleCore::Key::Right);
+
+	measure("LineEditor: edit mid-entry", "keys", minTime, [&]()
+	{
+		for(auto i = 0u; i < 32; ++i)
+			editing.input(static_cast<sf::Uint32>('A' + i));
+
+		for(auto i = 0u; i < 32; ++i)
+			editing.input(static_cast<sf::Uint32>('\b'));
+
+		editing.getGrid().clearDirty();
+		return 64;
+	});
+
+	/* CommandRegistry */
+
+	cnsl::CommandRegistry registry;
+
+	for(auto i = 0u; i < 4096; ++i)
+		registry.add(sf::String{"cmd_" + std::to_string(i % 64) + "_" + std::to_string(i)}, [](cnsl::ArgsView) {});
+
+	const sf::String registered = "cmd_17_4049";
+	const sf::String prefix = "cmd_17_";
+	std::vector<sf::String> matches;
+
+	measure("CommandRegistry: find", "lookups", minTime, [&]()
+	{
+		return registry.find(registered) != nullptr ? 1 : 0;
+	});
+
+	measure("CommandRegistry: complete", "names", minTime, [&]()
+	{
+		matches.clear();
+		registry.complete(prefix, matches, 256);
+		return matches.size();
+	});
+
+	// what a console sharing the registry pays when it first adds a command of its own
+	measure("CommandRegistry: copy", "copies", minTime, [&]()
+	{
+		cnsl::CommandRegistry copy{registry};
+		return copy.size() != 0 ? 1 : 0;
+	});
+
+	/* split / Tokenizer */
+
+	const sf::String args = "set some.long.variable.name 1234 and a few more words";
+
+	measure("split", "chars", minTime, [&]()
+	{
+		return cnsl::split(args, ' ').size() != 0 ? args.getSize() : 0;
+	});
+
+	cnsl::Tokenizer tokenizer;
+	const sf::String quoted = "set \"some long\" 'quoted value' and\\ escaped\\ words";
+
+	measure("Tokenizer: plain words", "chars", minTime, [&]()
+	{
+		return tokenizer.tokenize(args).size() != 0 ? args.getSize() : 0;
+	});
+
+	measure("Tokenizer: quotes and escapes", "chars", minTime, [&]()
+	{
+		return tokenizer.tokenize(quoted).size() != 0 ? quoted.getSize() : 0;
+	});
+
+	/* std::hash<sf::String> */
+
+	std::hash<sf::String> hash;
+	std::size_t hashes = 0;
+
+	const sf::String keys[] = {"echo", makeText(16, 1), makeText(60, 1)};
+
+	for(auto& key : keys)
+	{
+		auto chars = std::to_string(key.getSize()) + " chars";
+
+		measure("hash: FNV-1a, " + chars, "hashes", minTime, [&]()
+		{
+			hashes ^= fnv1a(key);
+			return 1;
+		});
+
+		measure("hash: " + chars, "hashes", minTime, [&]()
+		{
+			hashes ^= hash(key);
+			return 1;
+		});
+	}
+
+	/* BitmapFont::getTextureCoord */
+
+	std::size_t coords = 0;
+
+	measure("getTextureCoord: grid font", "lookups", minTime, [&]()
+	{
+		for(sf::Uint32 c = 32; c < 128; ++c)
+			coords += monoFont.getTextureCoord(c).x;
+
+		return 96;
+	});
+
+	// rasterizing glyphs needs a GL context, so only with a font given: Bench <file.ttf>
+	sf::Font trueType;
+
+	if(argc > 1 && trueType.loadFromFile(argv[1]))
+	{
+		sfml::BitmapFont bakedFont;
+		bakedFont.loadFromFont(trueType, 16);
+
+		measure("getTextureCoord: baked, hits", "lookups", minTime, [&]()
+		{
+			for(sf::Uint32 c = 32; c < 128; ++c)
+				coords += bakedFont.getTextureCoord(c).x;
+
+			return 96;
+		});
+
+		// CJK Unified Ideographs, through a cache a quarter of their size
+		bakedFont.loadFromFont(trueType, 16, 1024);
+		sf::Uint32 next = 0;
+
+		measure("getTextureCoord: baked, misses", "glyphs", minTime, [&]()
+		{
+			for(auto i = 0u; i < 64; ++i)
+				coords += bakedFont.getTextureCoord(0x4e00 + next++ % 4096).x;
+
+			bakedFont.getTexture();
+			return 64;
+		});
+	}
+
+	/* BitmapFont startup */
+
+	// loading the font and uploading its atlas, as at startup
+	std::size_t loaded = 0;
+
+	measure("load font: PNG", "loads", minTime, [&]()
+	{
+		sfml::BitmapFont font;
+		loaded += font.loadFromFile("res/font12.png", {12, 12});
+		font.getTexture();
+		return 1;
+	});
+
+#ifdef COMPILED_FONT12
+	measure("load font: compiled, mapped", "loads", minTime, [&]()
+	{
+		sfml::BitmapFont font;
+		loaded += font.loadFromCompiledFile(COMPILED_FONT12);
+		font.getTexture();
+		return 1;
+	});
+#endif
+
+#ifdef HAS_EMBEDDED_FONT12
+	measure("load font: compiled, embedded", "loads", minTime, [&]()
+	{
+		sfml::BitmapFont font;
+		loaded += font.loadFromCompiled(fonts::font12, sizeof(fonts::font12));
+		font.getTexture();
+		return 1;
+	});
+#endif
+
+	/* BitmapText::update */
+
+	sfml::BitmapText text{"", monoFont};
+	const sf::String paragraph = makeText(80, 24);
+
+	measure("BitmapText::update", "chars", minTime, [&]()
+	{
+		text.setString(paragraph);
+		return paragraph.getSize();
+	});
+
+	// keeps results alive
+	if(calls == 0 || hashes == 0 || coords == 0 || loaded == 0)
+		std::cout << '\n';
+
+	/* memory */
+
+	std::cout << '\n';
+
+	const sf::Vector2u sizes[] = {{80, 24}, {200, 60}, {400, 120}};
+
+	for(auto size : sizes)
+	{
+		for(auto rows : {500u, 5000u, 50000u})
+			footprint(monoFont, size, rows);
+	}
+
+	return 0;
+}
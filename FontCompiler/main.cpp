@@ -0,0 +1,104 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cctype>
+
+#include "BitmapFont.hpp"
+
+// compiles a bitmap font image for BitmapFont::loadFromCompiled(), so loading it skips decoding the image
+// optionally also writes a header embedding it as a constexpr array, so it needs no file at all
+
+namespace
+{
+	bool writeHeader(const std::string& filename, const std::string& name, const std::vector<char>& data)
+	{
+		std::ofstream out{filename, std::ios::binary};
+
+		if(!out)
+			return false;
+
+		std::string guard = "DBR_FONTS_";
+
+		for(auto c : name)
+			guard += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+
+		guard += "_HPP";
+
+		out << "// generated by FontCompiler. Don't edit\n"
+			<< "#ifndef " << guard << '\n'
+			<< "#define " << guard << "\n\n"
+			<< "namespace dbr\n{\n\tnamespace fonts\n\t{\n"
+			<< "\t\t// for sfml::BitmapFont::loadFromCompiled()\n"
+			<< "\t\talignas(4) inline constexpr unsigned char " << name << "[] =\n\t\t{";
+
+		static const char digits[] = "0123456789abcdef";
+
+		for(auto i = 0u; i < data.size(); ++i)
+		{
+			auto byte = static_cast<unsigned char>(data[i]);
+
+			out << (i % 16 == 0 ? "\n\t\t\t" : " ") << "0x" << digits[byte >> 4] << digits[byte & 0xf] << ',';
+		}
+
+		out << "\n\t\t};\n\t}\n}\n\n#endif\n";
+
+		return static_cast<bool>(out);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if(argc != 5 && argc != 7)
+	{
+		std::cerr << "Usage: " << argv[0] << " <image> <glyph width> <glyph height> <out.bfnt> [<out.hpp> <array name>]\n";
+		return 1;
+	}
+
+	unsigned width = 0;
+	unsigned height = 0;
+
+	try
+	{
+		width = std::stoul(argv[2]);
+		height = std::stoul(argv[3]);
+	}
+	catch(const std::exception&)
+	{
+		std::cerr << "Glyph width and height must be numbers\n";
+		return 1;
+	}
+
+	dbr::sfml::BitmapFont font;
+
+	if(!font.loadFromFile(argv[1], {width, height}))
+	{
+		std::cerr << "Couldn't load \"" << argv[1] << "\"\n";
+		return 1;
+	}
+
+	std::vector<char> data;
+
+	if(!font.compile(data))
+	{
+		std::cerr << "Couldn't compile \"" << argv[1] << "\"\n";
+		return 1;
+	}
+
+	std::ofstream out{argv[4], std::ios::binary};
+	out.write(data.data(), static_cast<std::streamsize>(data.size()));
+
+	if(!out)
+	{
+		std::cerr << "Couldn't write \"" << argv[4] << "\"\n";
+		return 1;
+	}
+
+	if(argc == 7 && !writeHeader(argv[5], argv[6], data))
+	{
+		std::cerr << "Couldn't write \"" << argv[5] << "\"\n";
+		return 1;
+	}
+
+	return 0;
+}
@@ -1,29 +1,304 @@
 #include "BitmapFont.hpp"
 
+#include <algorithm>
+#include <cmath>
+
+#include <SFML/Graphics/Glyph.hpp>
+
+namespace
+{
+	// compiled fonts are little endian 32 bit words: 'DBRF', version, glyph width and height,
+	// atlas width and height, glyph count. Then codepoint, x, y for each glyph, then the atlas's RGBA pixels
+	constexpr char COMPILED_MAGIC[4] = {'D', 'B', 'R', 'F'};
+	constexpr std::uint32_t COMPILED_VERSION = 1u;
+	constexpr std::size_t COMPILED_HEADER_SIZE = 7 * 4;
+	constexpr std::size_t COMPILED_GLYPH_SIZE = 3 * 4;
+
+	std::uint32_t readWord(const unsigned char* bytes)
+	{
+		return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | static_cast<std::uint32_t>(bytes[3]) << 24;
+	}
+
+	void writeWord(std::vector<char>& out, std::uint32_t word)
+	{
+		for(auto i = 0u; i < 4; ++i)
+			out.push_back(static_cast<char>(word >> (i * 8) & 0xff));
+	}
+}
+
 namespace dbr
 {
 	namespace sfml
 	{
+		BitmapFont::BitmapFont()
+			: atlas{},
+			texture{},
+			textureStale{false},
+			glyphSize{0, 0},
+			glyphs{},
+			missing{0, 0},
+			generation{0},
+			source{nullptr},
+			characterSize{0},
+			baseline{0},
+			slotColumns{0},
+			slots{},
+			newest{NO_SLOT},
+			oldest{NO_SLOT},
+			baked{},
+			pixels{nullptr},
+			pixelsSize{0, 0},
+			mapping{}
+		{}
+
 		bool BitmapFont::loadFromFile(const std::string& filename, const sf::Vector2u& glyphSize, const sf::IntRect& area)
 		{
-			this->glyphSize = glyphSize;
-			return texture.loadFromFile(filename, area);
+			sf::Image image;
+			return image.loadFromFile(filename) && loadFirstPage(image, glyphSize, area);
 		}
 
 		bool BitmapFont::loadFromMemory(const void* data, std::size_t sizeInBytes, const sf::Vector2u& glyphSize, const sf::IntRect& area)
 		{
-			this->glyphSize = glyphSize;
-			return texture.loadFromMemory(data, sizeInBytes, area);
+			sf::Image image;
+			return image.loadFromMemory(data, sizeInBytes) && loadFirstPage(image, glyphSize, area);
 		}
 
 		bool BitmapFont::loadFromStream(sf::InputStream& stream, const sf::Vector2u& glyphSize, const sf::IntRect& area)
 		{
-			this->glyphSize = glyphSize;
-			return texture.loadFromStream(stream, area);
+			sf::Image image;
+			return image.loadFromStream(stream) && loadFirstPage(image, glyphSize, area);
+		}
+
+		bool BitmapFont::loadFromFont(const sf::Font& font, unsigned int characterSize, std::size_t maxGlyphs)
+		{
+			if(characterSize == 0 || maxGlyphs == 0)
+				return false;
+
+			// monospace cells, as wide as an 'M', tall enough for the line spacing, and the tallest ascent and descent
+			int ascent = 0;
+			int descent = 0;
+
+			for(auto c : sf::String{L"|\u00c5\u00c9gjpqy"})
+			{
+				auto& bounds = font.getGlyph(c, characterSize, false).bounds;
+
+				ascent = std::max(ascent, static_cast<int>(std::ceil(-bounds.top)));
+				descent = std::max(descent, static_cast<int>(std::ceil(bounds.top + bounds.height)));
+			}
+
+			auto width = static_cast<unsigned int>(std::ceil(font.getGlyph('M', characterSize, false).advance));
+			auto height = std::max(static_cast<unsigned int>(std::ceil(font.getLineSpacing(characterSize))), static_cast<unsigned int>(ascent + descent));
+
+			if(width == 0 || height == 0)
+				return false;
+
+			glyphSize = {width, height};
+
+			source = &font;
+			this->characterSize = characterSize;
+			baseline = ascent + static_cast<int>(height - ascent - descent) / 2;
+
+			// about square, so neither side runs into the max texture size first
+			slotColumns = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(maxGlyphs))));
+			auto rows = static_cast<unsigned int>((maxGlyphs + slotColumns - 1) / slotColumns);
+
+			atlas.create(slotColumns * width, rows * height, sf::Color::Transparent);
+			textureStale = true;
+
+			glyphs.clear();
+			missing = {0, 0};
+			++generation;
+
+			slots.assign(maxGlyphs, Slot{0, NO_SLOT, NO_SLOT});
+			newest = NO_SLOT;
+			oldest = NO_SLOT;
+			baked.clear();
+
+			pixels = nullptr;
+			mapping.reset();
+
+			return true;
+		}
+
+		bool BitmapFont::loadFromCompiled(const void* data, std::size_t sizeInBytes)
+		{
+			auto* bytes = static_cast<const unsigned char*>(data);
+
+			if(!bytes || sizeInBytes < COMPILED_HEADER_SIZE || !std::equal(COMPILED_MAGIC, COMPILED_MAGIC + 4, bytes) || readWord(bytes + 4) != COMPILED_VERSION)
+				return false;
+
+			sf::Vector2u size{readWord(bytes + 8), readWord(bytes + 12)};
+			sf::Vector2u atlasSize{readWord(bytes + 16), readWord(bytes + 20)};
+			std::uint64_t count = readWord(bytes + 24);
+
+			// in 64 bits, and compared against what's left, so a hostile count or atlas size can't wrap around the check
+			std::uint64_t glyphBytes = count * COMPILED_GLYPH_SIZE;
+			std::uint64_t pixelCount = std::uint64_t{atlasSize.x} * atlasSize.y;
+			std::uint64_t left = sizeInBytes - COMPILED_HEADER_SIZE;
+
+			if(size.x == 0 || size.y == 0 || glyphBytes > left || pixelCount > (left - glyphBytes) / 4)
+				return false;
+
+			// only formed once they're known to point into the data
+			auto* glyphData = bytes + COMPILED_HEADER_SIZE;
+			auto* pixelData = glyphData + glyphBytes;
+
+			glyphSize = size;
+
+			atlas = sf::Image{};
+			glyphs.clear();
+			missing = {0, 0};
+			++generation;
+
+			source = nullptr;
+			slots.clear();
+			baked.clear();
+
+			for(auto i = 0u; i < count; ++i)
+			{
+				auto* glyph = glyphData + i * COMPILED_GLYPH_SIZE;
+				sf::Vector2u coord{readWord(glyph + 4), readWord(glyph + 8)};
+
+				// glyphs can't read past the atlas
+				if(coord.x + std::uint64_t{size.x} <= atlasSize.x && coord.y + std::uint64_t{size.y} <= atlasSize.y)
+					glyphs.insert(readWord(glyph), coord);
+			}
+
+			pixels = pixelData;
+			pixelsSize = atlasSize;
+			mapping.reset();
+			textureStale = true;
+
+			updateMissing();
+			return true;
+		}
+
+		bool BitmapFont::loadFromCompiledFile(const std::string& filename)
+		{
+			auto file = std::make_shared<cnsl::MappedFile>();
+
+			if(!file->open(filename) || !loadFromCompiled(file->data(), file->size()))
+				return false;
+
+			mapping = std::move(file);
+			return true;
+		}
+
+		bool BitmapFont::compile(std::vector<char>& out) const
+		{
+			if(source || glyphSize.x == 0 || glyphSize.y == 0)
+				return false;
+
+			auto size = pixels ? pixelsSize : atlas.getSize();
+			auto* data = pixels ? pixels : atlas.getPixelsPtr();
+
+			// in codepoint order, so compiling the same font gives the same bytes
+			std::vector<std::pair<sf::Uint32, sf::Vector2u>> sorted;
+			sorted.reserve(glyphs.size());
+
+			glyphs.forEach([&](sf::Uint32 codePoint, const GlyphIndex::Glyph& glyph)
+			{
+				sorted.emplace_back(codePoint, glyph.coord);
+			});
+
+			std::sort(sorted.begin(), sorted.end(), [](const std::pair<sf::Uint32, sf::Vector2u>& lhs, const std::pair<sf::Uint32, sf::Vector2u>& rhs)
+			{
+				return lhs.first < rhs.first;
+			});
+
+			out.reserve(out.size() + COMPILED_HEADER_SIZE + sorted.size() * COMPILED_GLYPH_SIZE + size.x * size.y * 4);
+
+			out.insert(out.end(), COMPILED_MAGIC, COMPILED_MAGIC + 4);
+			writeWord(out, COMPILED_VERSION);
+			writeWord(out, glyphSize.x);
+			writeWord(out, glyphSize.y);
+			writeWord(out, size.x);
+			writeWord(out, size.y);
+			writeWord(out, static_cast<std::uint32_t>(sorted.size()));
+
+			for(auto& glyph : sorted)
+			{
+				writeWord(out, glyph.first);
+				writeWord(out, glyph.second.x);
+				writeWord(out, glyph.second.y);
+			}
+
+			if(data)
+				out.insert(out.end(), reinterpret_cast<const char*>(data), reinterpret_cast<const char*>(data) + size.x * size.y * 4);
+
+			return true;
+		}
+
+		bool BitmapFont::addPage(const sf::Image& image, sf::Uint32 firstCodePoint, const sf::IntRect& area)
+		{
+			sf::Vector2u origin;
+			sf::Vector2u count;
+
+			if(!appendPage(image, area, origin, count))
+				return false;
+
+			for(auto i = 0u; i < count.x * count.y; ++i)
+				glyphs.insert(firstCodePoint + i, {origin.x + glyphSize.x * (i % count.x), origin.y + glyphSize.y * (i / count.x)});
+
+			updateMissing();
+			return true;
+		}
+
+		bool BitmapFont::addPage(const sf::Image& image, const sf::String& codePoints, const sf::IntRect& area)
+		{
+			sf::Vector2u origin;
+			sf::Vector2u count;
+
+			if(!appendPage(image, area, origin, count))
+				return false;
+
+			auto num = std::min<std::size_t>(codePoints.getSize(), count.x * count.y);
+
+			for(auto i = 0u; i < num; ++i)
+				glyphs.insert(codePoints[i], {origin.x + glyphSize.x * (i % count.x), origin.y + glyphSize.y * (i / count.x)});
+
+			updateMissing();
+			return true;
 		}
 
 		const sf::Texture& BitmapFont::getTexture() const
 		{
+			copyBaked();
+
+			if(textureStale)
+			{
+				// compiled fonts upload straight from where they were loaded
+				if(pixels)
+				{
+					texture.create(pixelsSize.x, pixelsSize.y);
+					texture.update(pixels);
+				}
+				else
+				{
+					texture.loadFromImage(atlas);
+				}
+
+				textureStale = false;
+				baked.clear();
+			}
+			else if(!baked.empty())
+			{
+				// only the cells that changed
+				sf::Image cell;
+				cell.create(glyphSize.x, glyphSize.y);
+
+				for(auto slot : baked)
+				{
+					auto x = static_cast<unsigned int>(slot % slotColumns * glyphSize.x);
+					auto y = static_cast<unsigned int>(slot / slotColumns * glyphSize.y);
+
+					cell.copy(atlas, 0, 0, {static_cast<int>(x), static_cast<int>(y), static_cast<int>(glyphSize.x), static_cast<int>(glyphSize.y)});
+					texture.update(cell, x, y);
+				}
+
+				baked.clear();
+			}
+
 			return texture;
 		}
 
@@ -39,22 +314,214 @@ namespace dbr
 
 		sf::Vector2u BitmapFont::getTextureCoord(sf::Uint32 codePoint) const
 		{
-			const auto texSize = texture.getSize();
-			const auto cols = texSize.x / glyphSize.x;
-			const auto rows = texSize.y / glyphSize.y;
+			auto* glyph = glyphs.find(codePoint);
+
+			if(glyph)
+			{
+				if(source && glyph->cell != newest)
+				{
+					unlink(glyph->cell);
+					pushNewest(glyph->cell);
+				}
+
+				return glyph->coord;
+			}
+
+			// requested a codePoint we don't have
+			return source ? bake(codePoint) : missing;
+		}
+
+		std::size_t BitmapFont::getGeneration() const
+		{
+			return generation;
+		}
+
+		bool BitmapFont::loadFirstPage(const sf::Image& image, const sf::Vector2u& glyphSize, const sf::IntRect& area)
+		{
+			if(glyphSize.x == 0 || glyphSize.y == 0)
+				return false;
+
+			this->glyphSize = glyphSize;
 
-			// cancel out control characters
-			codePoint -= 32;
+			atlas = sf::Image{};
+			glyphs.clear();
+			missing = {0, 0};
+			++generation;
 
-			if(codePoint < cols * rows)
+			source = nullptr;
+			slots.clear();
+			baked.clear();
+
+			pixels = nullptr;
+			mapping.reset();
+
+			return addPage(image, 32u, area);
+		}
+
+		bool BitmapFont::appendPage(const sf::Image& image, const sf::IntRect& area, sf::Vector2u& pageOrigin, sf::Vector2u& pageGlyphs)
+		{
+			if(glyphSize.x == 0 || glyphSize.y == 0 || source)
+				return false;
+
+			ownPixels();
+
+			auto imageSize = image.getSize();
+			sf::IntRect rect = area.width > 0 && area.height > 0 ? area : sf::IntRect{0, 0, static_cast<int>(imageSize.x), static_cast<int>(imageSize.y)};
+
+			// only whole glyphs are kept, so every page starts on a glyph boundary
+			pageGlyphs = {rect.width / glyphSize.x, rect.height / glyphSize.y};
+			rect.width = pageGlyphs.x * glyphSize.x;
+			rect.height = pageGlyphs.y * glyphSize.y;
+
+			if(pageGlyphs.x == 0 || pageGlyphs.y == 0)
+				return false;
+
+			auto oldSize = atlas.getSize();
+			sf::Vector2u newSize = {std::max<unsigned int>(oldSize.x, rect.width), oldSize.y + rect.height};
+
+			sf::Image grown;
+			grown.create(newSize.x, newSize.y, sf::Color::Transparent);
+
+			if(oldSize.y > 0)
+				grown.copy(atlas, 0, 0);
+
+			grown.copy(image, 0, oldSize.y, rect);
+
+			atlas = std::move(grown);
+			textureStale = true;
+			pageOrigin = {0, oldSize.y};
+
+			return true;
+		}
+
+		sf::Vector2u BitmapFont::bake(sf::Uint32 codePoint) const
+		{
+			std::size_t slot;
+
+			// cells are handed out in order until they run out, as the font only ever grows until then
+			if(glyphs.size() < slots.size())
 			{
-				return{glyphSize.x * (codePoint % cols), glyphSize.y * (codePoint / cols)};
+				slot = glyphs.size();
 			}
 			else
 			{
-				// requested a codePoint we don't have
-				return{0, 0};
+				slot = oldest;
+				unlink(slot);
+
+				glyphs.erase(slots[slot].codePoint);
+				++generation;
 			}
+
+			slots[slot].codePoint = codePoint;
+			pushNewest(slot);
+
+			sf::Vector2u coord{static_cast<unsigned int>(slot % slotColumns * glyphSize.x), static_cast<unsigned int>(slot / slotColumns * glyphSize.y)};
+			glyphs.insert(codePoint, coord, static_cast<sf::Uint32>(slot));
+
+			// rasterized now, but read back from the font's texture along with the rest, by the next getTexture()
+			source->getGlyph(codePoint, characterSize, false);
+			baked.push_back(slot);
+
+			return coord;
+		}
+
+		void BitmapFont::pushNewest(std::size_t slot) const
+		{
+			slots[slot].newer = NO_SLOT;
+			slots[slot].older = newest;
+
+			if(newest != NO_SLOT)
+				slots[newest].newer = slot;
+			else
+				oldest = slot;
+
+			newest = slot;
+		}
+
+		void BitmapFont::unlink(std::size_t slot) const
+		{
+			auto& s = slots[slot];
+
+			if(s.newer != NO_SLOT)
+				slots[s.newer].older = s.older;
+			else
+				newest = s.older;
+
+			if(s.older != NO_SLOT)
+				slots[s.older].newer = s.newer;
+			else
+				oldest = s.newer;
+
+			s.newer = NO_SLOT;
+			s.older = NO_SLOT;
+		}
+
+		void BitmapFont::copyBaked() const
+		{
+			if(baked.empty())
+				return;
+
+			// the glyphs are on the GPU, so this is one read back per frame that rasterized any
+			auto page = source->getTexture(characterSize).copyToImage();
+
+			sf::Image blank;
+			blank.create(glyphSize.x, glyphSize.y, sf::Color::Transparent);
+
+			for(auto slot : baked)
+			{
+				auto x = static_cast<unsigned int>(slot % slotColumns * glyphSize.x);
+				auto y = static_cast<unsigned int>(slot / slotColumns * glyphSize.y);
+
+				atlas.copy(blank, x, y);
+
+				auto& glyph = source->getGlyph(slots[slot].codePoint, characterSize, false);
+
+				// place it on the baseline, clipped to the cell
+				auto rect = glyph.textureRect;
+				auto left = static_cast<int>(std::floor(glyph.bounds.left + 0.5f));
+				auto top = baseline + static_cast<int>(std::floor(glyph.bounds.top + 0.5f));
+
+				if(left < 0)
+				{
+					rect.left -= left;
+					rect.width += left;
+					left = 0;
+				}
+
+				if(top < 0)
+				{
+					rect.top -= top;
+					rect.height += top;
+					top = 0;
+				}
+
+				rect.width = std::min(rect.width, static_cast<int>(glyphSize.x) - left);
+				rect.height = std::min(rect.height, static_cast<int>(glyphSize.y) - top);
+
+				if(rect.width > 0 && rect.height > 0)
+					atlas.copy(page, x + left, y + top, rect);
+			}
+		}
+
+		void BitmapFont::ownPixels()
+		{
+			if(!pixels)
+				return;
+
+			atlas.create(pixelsSize.x, pixelsSize.y, pixels);
+
+			pixels = nullptr;
+			mapping.reset();
+		}
+
+		void BitmapFont::updateMissing()
+		{
+			auto* glyph = glyphs.find(0xfffd);
+
+			if(!glyph)
+				glyph = glyphs.find('?');
+
+			missing = glyph ? glyph->coord : sf::Vector2u{0, 0};
 		}
 	}
 }
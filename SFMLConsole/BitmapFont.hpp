@@ -3,10 +3,18 @@
 
 #include <array>
 #include <vector>
+#include <memory>
+#include <cstdint>
 
 #include <SFML/System/InputStream.hpp>
+#include <SFML/System/String.hpp>
 #include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/Image.hpp>
 #include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Font.hpp>
+
+#include "GlyphIndex.hpp"
+#include "MappedFile.hpp"
 
 namespace dbr
 {
@@ -16,20 +24,58 @@ namespace dbr
 			Represents a bitmap font.
 			Glyph indices should increment left and down, starting with Unicode 32 (space)
 			If a codepoint is not needed, leave empty space for the codepoint in the image
-			Max codepoint is limited by the max texture size of the graphics card
+			Further pages can be added for other ranges or sets of codepoints (box drawing, Cyrillic, CJK, ...)
+			All pages are packed into a single texture, stacked top to bottom,
+			so max codepoints are limited by the max texture size of the graphics card
+			The texture is only created on the first getTexture(), so fonts can be loaded and queried
+			without a window or GL context (headless builds, benchmarks)
+
+			Alternatively, glyphs can be rasterized from an sf::Font (TTF, OTF, ...) the first time they are asked for,
+			into a fixed grid of cells, reusing the least recently used cell once full. Coordinates of evicted glyphs
+			then point to another glyph, which getGeneration() tells drawables about.
+			BitmapText doesn't check it, so give it a font that never evicts
+
+			Fonts can be compiled (compile(), or the FontCompiler tool) to a format holding the glyph size,
+			codepoints, and raw atlas pixels, which loads without decoding anything, and without copying the pixels
 		*/
 		class BitmapFont
 		{
 		public:
-			BitmapFont() = default;
+			BitmapFont();
 			~BitmapFont() = default;
 
-			// calls corresponding texture.loadFrom*(...)
+			// loads the first page, starting at codepoint 32, replacing any existing pages
 			// because of this, the memory provided by data/stream does not need to be preserved after this call
 			bool loadFromFile(const std::string& filename, const sf::Vector2u& glyphSize, const sf::IntRect& area = sf::IntRect{});
 			bool loadFromMemory(const void* data, std::size_t sizeInBytes, const sf::Vector2u& glyphSize, const sf::IntRect& area = sf::IntRect{});
 			bool loadFromStream(sf::InputStream& stream, const sf::Vector2u& glyphSize, const sf::IntRect& area = sf::IntRect{});
 
+			// glyphs are rasterized by font at characterSize on their first getTextureCoord(), into cells sized by 'M'
+			// and the font's line spacing. Glyphs wider than that are clipped. Keeps up to maxGlyphs glyphs, so the
+			// atlas is about maxGlyphs * cell size * 4 bytes. Keep it above the number of distinct glyphs on screen.
+			// font must outlive this. Rasterizing needs a GL context, as sf::Font rasterizes into a texture
+			bool loadFromFont(const sf::Font& font, unsigned int characterSize, std::size_t maxGlyphs = DEFAULT_MAX_GLYPHS);
+
+			// loads a font written by compile(), reading the pixels in place: data must outlive the font (and its copies)
+			// meant for arrays generated by FontCompiler and linked into the binary, which are never freed
+			bool loadFromCompiled(const void* data, std::size_t sizeInBytes);
+
+			// maps filename, and loads it with loadFromCompiled(). The font (and its copies) keep the file mapped
+			bool loadFromCompiledFile(const std::string& filename);
+
+			// appends the compiled font to out. Fails for fonts loaded with loadFromFont(), as their glyphs come and go
+			bool compile(std::vector<char>& out) const;
+
+			// adds a page of glyphs, sized by the loaded glyph size, to the font
+			// glyphs are assigned codepoints incrementing from firstCodePoint
+			// fonts loaded with loadFromFont() have no pages, so this fails for them
+			bool addPage(const sf::Image& image, sf::Uint32 firstCodePoint, const sf::IntRect& area = sf::IntRect{});
+
+			// glyphs are assigned the codepoints of codePoints, in order
+			bool addPage(const sf::Image& image, const sf::String& codePoints, const sf::IntRect& area = sf::IntRect{});
+
+			// uploads the atlas if pages were added, or glyphs rasterized, since the last call
+			// if the atlas is larger than the max texture size, the texture is left empty
 			const sf::Texture& getTexture() const;
 			const sf::Vector2u& getGlyphSize() const;
 
@@ -37,12 +83,73 @@ namespace dbr
 			void smooth(bool s);
 
 			// returns the top-left texture coordinate of codePoint
-			// if does not exist, returns {0, 0}
+			// if does not exist, returns the coordinate of U+FFFD or '?' if the font has either, otherwise {0, 0}
+			// with loadFromFont(), rasterizes codePoint if it isn't in the atlas
 			sf::Vector2u getTextureCoord(sf::Uint32 codePoint) const;
 
+			// changes when coordinates returned before may have become another glyph's (evicted, or the font reloaded)
+			std::size_t getGeneration() const;
+
 		private:
-			sf::Texture texture;
+			static constexpr std::size_t DEFAULT_MAX_GLYPHS = 4096u;
+			static constexpr std::size_t NO_SLOT = static_cast<std::size_t>(-1);
+
+			// a cell of the atlas, for fonts loaded with loadFromFont()
+			// the cells in use are linked from the most to the least recently used, so evicting is constant time
+			struct Slot
+			{
+				sf::Uint32 codePoint;
+				std::size_t newer;	// NO_SLOT if it's the newest
+				std::size_t older;	// NO_SLOT if it's the oldest
+			};
+
+			// gives codePoint a cell, evicting the least recently used glyph if all are taken
+			// its pixels are copied in by the next getTexture()
+			sf::Vector2u bake(sf::Uint32 codePoint) const;
+
+			// puts slot at the front of the recently used list. It must not be in it
+			void pushNewest(std::size_t slot) const;
+
+			// takes slot out of the recently used list
+			void unlink(std::size_t slot) const;
+
+			// copies glyphs baked since the last call from the sf::Font's texture into the atlas
+			void copyBaked() const;
+
+			// clears all pages, and loads image as the first page
+			bool loadFirstPage(const sf::Image& image, const sf::Vector2u& glyphSize, const sf::IntRect& area);
+
+			// copies a compiled font's pixels into atlas, so pages can be added to it
+			void ownPixels();
+
+			// copies image into the bottom of the atlas. Returns the top-left of the page in the atlas
+			bool appendPage(const sf::Image& image, const sf::IntRect& area, sf::Vector2u& pageOrigin, sf::Vector2u& pageGlyphs);
+
+			void updateMissing();
+
+			// mutable, as glyphs of a loadFromFont() font are added when they are first drawn
+			mutable sf::Image atlas;
+			mutable sf::Texture texture;
+			mutable bool textureStale;
 			sf::Vector2u glyphSize;
+
+			mutable GlyphIndex glyphs;
+			sf::Vector2u missing;
+			mutable std::size_t generation;
+
+			const sf::Font* source;		// nullptr unless loaded with loadFromFont()
+			unsigned int characterSize;
+			int baseline;				// from the top of a cell
+			unsigned int slotColumns;
+			mutable std::vector<Slot> slots;
+			mutable std::size_t newest;	// ends of the recently used list. NO_SLOT if it's empty
+			mutable std::size_t oldest;
+			mutable std::vector<std::size_t> baked;	// slots not copied into the atlas yet
+
+			// a compiled font's atlas, read in place. nullptr if the atlas is in atlas
+			const sf::Uint8* pixels;
+			sf::Vector2u pixelsSize;
+			std::shared_ptr<const cnsl::MappedFile> mapping;	// what pixels points into, if loaded from a file
 		};
 	}
 }
@@ -1,5 +1,7 @@
 #include "BitmapText.hpp"
 
+#include <algorithm>
+
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/RenderStates.hpp>
 
@@ -130,7 +132,6 @@ namespace dbr
 
 					// we didn't add a drawable character
 NoDrawable:
-					case -1:
 						--vertIdx;
 						continue;
 
@@ -0,0 +1,41 @@
+#include "CVar.hpp"
+
+#include <charconv>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		namespace
+		{
+			template<typename T>
+			std::string formatFloat(T value)
+			{
+				// the shortest form that parses back to value
+				char buffer[64];
+				auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+				return {buffer, result.ptr};
+			}
+		}
+
+		CVarBase::CVarBase(const sf::String& description)
+			: description{description}
+		{}
+
+		std::string formatValue(bool value)
+		{
+			return value ? "true" : "false";
+		}
+
+		std::string formatValue(float value)
+		{
+			return formatFloat(value);
+		}
+
+		std::string formatValue(double value)
+		{
+			return formatFloat(value);
+		}
+	}
+}
@@ -0,0 +1,212 @@
+#ifndef DBR_CNSL_CVAR_HPP
+#define DBR_CNSL_CVAR_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <SFML/System/String.hpp>
+
+#include "StringView.hpp"
+#include "TypedCommand.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			Console variables: typed values, added by name with ConsoleCore::addCVar(), and set from the console.
+			A CVar is a handle to one, kept by whatever reads it. Reading it is a single atomic load, with no lookup
+			or lock, so any thread can read it in a hot loop.
+			Values are bools, integers, floats and doubles, which std::atomic holds without a lock
+		*/
+
+		// a variable, whatever its type. What the console sets, prints, and saves
+		class CVarBase
+		{
+		public:
+			explicit CVarBase(const sf::String& description);
+			virtual ~CVarBase() = default;
+
+			CVarBase(const CVarBase&) = delete;
+			CVarBase& operator=(const CVarBase&) = delete;
+
+			// parsed as a typed command's argument is (see parseArg()). false, leaving it unchanged, if it doesn't parse
+			virtual bool set(StringView value) = 0;
+
+			// formatted so set() parses it back to the same value
+			virtual std::string get() const = 0;
+			virtual std::string getDefault() const = 0;
+
+			// as in usage messages: "bool", "int", "uint" or "number"
+			virtual const char* getType() const = 0;
+
+			const sf::String description;
+		};
+
+		// formats value so parseArg() parses it back to the same value
+		std::string formatValue(bool value);
+		std::string formatValue(float value);
+		std::string formatValue(double value);
+
+		template<typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+		std::string formatValue(T value);
+
+		template<typename T>
+		class CVarValue : public CVarBase
+		{
+			static_assert(std::is_arithmetic_v<T> && std::atomic<T>::is_always_lock_free, "CVars must be bools, integers, floats or doubles");
+
+		public:
+			CVarValue(T value, const sf::String& description);
+
+			bool set(StringView value) override;
+			std::string get() const override;
+			std::string getDefault() const override;
+			const char* getType() const override;
+
+			T load() const;
+
+			// runs the change callbacks, on the calling thread, if value differs from the current value
+			void store(T value);
+
+			// callbacks should be added before other threads set the variable
+			void onChange(std::function<void(T value)>&& callback);
+
+		private:
+			std::atomic<T> value;
+			const T defaultValue;
+			std::vector<std::function<void(T value)>> callbacks;
+		};
+
+		// a handle to a variable, shared with the console (and any copies of it)
+		template<typename T>
+		class CVar
+		{
+		public:
+			// not a handle to any variable. Only isBound() can be called
+			CVar();
+			explicit CVar(std::shared_ptr<CVarValue<T>> variable);
+
+			bool isBound() const;
+
+			// a relaxed atomic load, so it is cheap enough for hot loops, but may not see a value set on
+			// another thread at the same time until a later read
+			T get() const;
+
+			// as from the console: runs the change callbacks, on the calling thread, if the value changed
+			void set(T value);
+
+			void onChange(std::function<void(T value)> callback);
+
+		private:
+			std::shared_ptr<CVarValue<T>> variable;
+		};
+
+		template<typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int>>
+		std::string formatValue(T value)
+		{
+			return std::to_string(value);
+		}
+
+		template<typename T>
+		CVarValue<T>::CVarValue(T value, const sf::String& description)
+			: CVarBase{description},
+			value{value},
+			defaultValue{value},
+			callbacks{}
+		{}
+
+		template<typename T>
+		bool CVarValue<T>::set(StringView value)
+		{
+			T parsed;
+
+			if(!parseArg(value, parsed))
+				return false;
+
+			store(parsed);
+			return true;
+		}
+
+		template<typename T>
+		std::string CVarValue<T>::get() const
+		{
+			return formatValue(load());
+		}
+
+		template<typename T>
+		std::string CVarValue<T>::getDefault() const
+		{
+			return formatValue(defaultValue);
+		}
+
+		template<typename T>
+		const char* CVarValue<T>::getType() const
+		{
+			return argName<T>();
+		}
+
+		template<typename T>
+		T CVarValue<T>::load() const
+		{
+			return value.load(std::memory_order_relaxed);
+		}
+
+		template<typename T>
+		void CVarValue<T>::store(T value)
+		{
+			if(this->value.exchange(value, std::memory_order_relaxed) == value)
+				return;
+
+			for(auto& callback : callbacks)
+				callback(value);
+		}
+
+		template<typename T>
+		void CVarValue<T>::onChange(std::function<void(T value)>&& callback)
+		{
+			callbacks.push_back(std::move(callback));
+		}
+
+		template<typename T>
+		CVar<T>::CVar()
+			: variable{nullptr}
+		{}
+
+		template<typename T>
+		CVar<T>::CVar(std::shared_ptr<CVarValue<T>> variable)
+			: variable{std::move(variable)}
+		{}
+
+		template<typename T>
+		bool CVar<T>::isBound() const
+		{
+			return variable != nullptr;
+		}
+
+		template<typename T>
+		T CVar<T>::get() const
+		{
+			return variable->load();
+		}
+
+		template<typename T>
+		void CVar<T>::set(T value)
+		{
+			variable->store(value);
+		}
+
+		template<typename T>
+		void CVar<T>::onChange(std::function<void(T value)> callback)
+		{
+			variable->onChange(std::move(callback));
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,238 @@
+#include "CommandRegistry.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		CommandRegistry::CommandRegistry()
+			: nodes{},
+			commands{}
+		{
+			nodes.push_back({0, NONE, NONE, NONE, 0});
+		}
+
+		void CommandRegistry::add(StringView name, CommandView&& command)
+		{
+			Handler handler;
+			handler.view = std::move(command);
+
+			add(name, std::move(handler));
+		}
+
+		void CommandRegistry::add(StringView name, AsyncCommand&& command)
+		{
+			Handler handler;
+			handler.async = std::move(command);
+
+			add(name, std::move(handler));
+		}
+
+#ifdef DBR_CNSL_COROUTINES
+		void CommandRegistry::add(StringView name, FrameCommand&& command)
+		{
+			Handler handler;
+			handler.frame = std::move(command);
+
+			add(name, std::move(handler));
+		}
+#endif
+
+		void CommandRegistry::add(StringView name, std::shared_ptr<CVarBase>&& cvar)
+		{
+			Handler handler;
+			handler.cvar = std::move(cvar);
+
+			add(name, std::move(handler));
+		}
+
+		const CommandRegistry::Handler* CommandRegistry::find(StringView name) const
+		{
+			auto node = findNode(name);
+
+			return node != NONE && nodes[node].command != NONE ? commands[nodes[node].command].get() : nullptr;
+		}
+
+		bool CommandRegistry::contains(StringView name) const
+		{
+			return find(name) != nullptr;
+		}
+
+		std::size_t CommandRegistry::size() const
+		{
+			return commands.size();
+		}
+
+		std::size_t CommandRegistry::count(StringView prefix) const
+		{
+			auto node = findNode(prefix);
+
+			return node != NONE ? nodes[node].names : 0;
+		}
+
+		sf::String CommandRegistry::commonPrefix(StringView prefix) const
+		{
+			auto result = prefix.toString();
+			auto node = findNode(prefix);
+
+			if(node == NONE)
+				return result;
+
+			// extend while there is only one way on, and no name ends on the way
+			while(nodes[node].command == NONE)
+			{
+				auto first = nodes[node].firstChild;
+
+				if(first == NONE || nodes[first].nextSibling != NONE)
+					break;
+
+				result += nodes[first].character;
+				node = first;
+			}
+
+			return result;
+		}
+
+		void CommandRegistry::complete(StringView prefix, std::vector<sf::String>& names, std::size_t max) const
+		{
+			auto start = findNode(prefix);
+
+			if(start == NONE || max == 0)
+				return;
+
+			std::basic_string<sf::Uint32> name{prefix.begin(), prefix.end()};
+
+			struct Visit
+			{
+				std::uint32_t node;
+				std::size_t length;	// of name, before the node's character
+			};
+
+			std::vector<Visit> stack;
+			std::size_t added = 0;
+
+			auto visitChildren = [&](std::uint32_t node)
+			{
+				// pushed in reverse, so the smallest character is visited first
+				auto mark = stack.size();
+
+				for(auto c = nodes[node].firstChild; c != NONE; c = nodes[c].nextSibling)
+					stack.push_back({c, name.size()});
+
+				std::reverse(stack.begin() + mark, stack.end());
+			};
+
+			if(nodes[start].command != NONE)
+			{
+				names.push_back(sf::String::fromUtf32(name.begin(), name.end()));
+				++added;
+			}
+
+			visitChildren(start);
+
+			while(!stack.empty() && added < max)
+			{
+				auto visit = stack.back();
+				stack.pop_back();
+
+				name.resize(visit.length);
+				name += nodes[visit.node].character;
+
+				if(nodes[visit.node].command != NONE)
+				{
+					names.push_back(sf::String::fromUtf32(name.begin(), name.end()));
+					++added;
+				}
+
+				visitChildren(visit.node);
+			}
+		}
+
+		std::uint32_t CommandRegistry::child(std::uint32_t node, sf::Uint32 character) const
+		{
+			for(auto c = nodes[node].firstChild; c != NONE; c = nodes[c].nextSibling)
+			{
+				if(nodes[c].character == character)
+					return c;
+
+				// sorted, so it isn't further on
+				if(nodes[c].character > character)
+					break;
+			}
+
+			return NONE;
+		}
+
+		std::uint32_t CommandRegistry::findNode(StringView prefix) const
+		{
+			std::uint32_t node = 0;
+
+			for(auto c : prefix)
+			{
+				node = child(node, c);
+
+				if(node == NONE)
+					break;
+			}
+
+			return node;
+		}
+
+		void CommandRegistry::add(StringView name, Handler&& handler)
+		{
+			std::uint32_t node = 0;
+
+			for(auto c : name)
+			{
+				// children are kept sorted, so a missing child is inserted where the search stopped
+				auto prev = NONE;
+				auto next = nodes[node].firstChild;
+
+				while(next != NONE && nodes[next].character < c)
+				{
+					prev = next;
+					next = nodes[next].nextSibling;
+				}
+
+				if(next == NONE || nodes[next].character != c)
+				{
+					auto created = static_cast<std::uint32_t>(nodes.size());
+					nodes.push_back({c, NONE, next, NONE, 0});
+
+					if(prev == NONE)
+						nodes[node].firstChild = created;
+					else
+						nodes[prev].nextSibling = created;
+
+					next = created;
+				}
+
+				node = next;
+			}
+
+			// replaced rather than assigned to, as copies of the registry may share it
+			auto shared = std::make_shared<const Handler>(std::move(handler));
+
+			if(nodes[node].command != NONE)
+			{
+				commands[nodes[node].command] = std::move(shared);
+				return;
+			}
+
+			nodes[node].command = static_cast<std::uint32_t>(commands.size());
+			commands.push_back(std::move(shared));
+
+			// count the new name on every node of its path
+			node = 0;
+			++nodes[node].names;
+
+			for(auto c : name)
+			{
+				node = child(node, c);
+				++nodes[node].names;
+			}
+		}
+	}
+}
@@ -0,0 +1,106 @@
+#ifndef DBR_CNSL_COMMAND_REGISTRY_HPP
+#define DBR_CNSL_COMMAND_REGISTRY_HPP
+
+#include <vector>
+#include <functional>
+#include <memory>
+#include <cstdint>
+
+#include <SFML/System/String.hpp>
+
+#include "StringView.hpp"
+#include "Tokenizer.hpp"
+#include "FrameTask.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		class Job;
+		class CVarBase;
+
+		// takes its arguments as views into the entry, so running it doesn't copy them
+		using CommandView = std::function<void(ArgsView args)>;
+
+		// runs on a worker thread, so it doesn't hold up the frame. Prints through job, and should return early once it's cancelled
+		// arguments are copied, as the entry is gone by the time it runs
+		using AsyncCommand = std::function<void(const Args& args, Job& job)>;
+
+		/*
+			Commands by name, in a prefix trie.
+			Finding a command, or the names starting with a prefix, walks one node per character of the name/prefix,
+			so it costs the same with ten commands as with ten thousand.
+			Nodes keep their children as a linked list sorted by character, so names come out in sorted order,
+			and each node counts the names below it, so counting matches doesn't visit them.
+			Handlers can't be changed once added, so copies of a registry share them, and copying only costs the nodes
+		*/
+		class CommandRegistry
+		{
+		public:
+			// what running a name calls, or the variable it names. At most one is set. None are set for builtins
+			struct Handler
+			{
+				CommandView view;
+				AsyncCommand async;
+#ifdef DBR_CNSL_COROUTINES
+				FrameCommand frame;
+#endif
+				std::shared_ptr<CVarBase> cvar;
+			};
+
+			CommandRegistry();
+
+			// replace any command already named name
+			void add(StringView name, CommandView&& command);
+			void add(StringView name, AsyncCommand&& command);
+#ifdef DBR_CNSL_COROUTINES
+			void add(StringView name, FrameCommand&& command);
+#endif
+			void add(StringView name, std::shared_ptr<CVarBase>&& cvar);
+
+			// nullptr if no command is named name
+			const Handler* find(StringView name) const;
+
+			bool contains(StringView name) const;
+
+			// number of names
+			std::size_t size() const;
+
+			// number of names starting with prefix
+			std::size_t count(StringView prefix) const;
+
+			// the longest string that every name starting with prefix starts with
+			// returns prefix itself if nothing longer is shared, or nothing starts with it
+			sf::String commonPrefix(StringView prefix) const;
+
+			// appends up to max names starting with prefix to names, in sorted order
+			void complete(StringView prefix, std::vector<sf::String>& names, std::size_t max) const;
+
+		private:
+			struct Node
+			{
+				sf::Uint32 character;
+				std::uint32_t firstChild;
+				std::uint32_t nextSibling;
+				std::uint32_t command;	// index in commands, or NONE
+				std::uint32_t names;	// names ending at or below this node
+			};
+
+			static constexpr std::uint32_t NONE = static_cast<std::uint32_t>(-1);
+
+			// NONE if node has no child for character
+			std::uint32_t child(std::uint32_t node, sf::Uint32 character) const;
+
+			// NONE if no name starts with prefix
+			std::uint32_t findNode(StringView prefix) const;
+
+			void add(StringView name, Handler&& handler);
+
+			// nodes[0] is the root, the empty name
+			std::vector<Node> nodes;
+			std::vector<std::shared_ptr<const Handler>> commands;
+		};
+	}
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "Console.hpp"
 
+#include <algorithm>
+
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/Transformable.hpp>
 #include <SFML/Graphics/Drawable.hpp>
@@ -9,36 +11,36 @@
 
 #include "BitmapFont.hpp"
 
-static std::vector<sf::String> split(const sf::String& str, sf::Uint32 splitOn)
-{
-	std::vector<sf::String> ret;
+// draws the visible rows of Console's grid texture onto a quad with texture coordinates from {0, 0} to {1, 1}
+// GLSL 1.10, so it runs on anything down to Mesa's software rasterizers
+static const char* GRID_FRAGMENT_SHADER = R"(
+#version 110
 
-	auto start = str.begin();
+uniform sampler2D atlas;
+uniform sampler2D grid;
+uniform sampler2D palette;	// 256 x 1, color of attribute n at texel n
 
-	auto sub = [&](auto last)
-	{
-		auto off = std::distance(str.begin(), start);
-		auto len = std::distance(start, last);
+uniform vec2 gridSize;		// in cells
+uniform vec2 atlasGlyphs;	// atlas size in glyphs
+uniform float topRow;		// grid row at the top of the view
 
-		if(len != 0)
-			ret.emplace_back(str.substring(off, len));
-	};
+void main()
+{
+	vec2 cell = gl_TexCoord[0].xy * gridSize;
+	vec2 index = floor(cell);
+	index.y = mod(index.y + topRow, gridSize.y);
 
-	for(auto it = start; it != str.end(); ++it)
-	{
-		if(*it == splitOn)
-		{
-			sub(it);
-			start = std::next(it);
-		}
-	}
+	vec4 texel = floor(texture2D(grid, (index + 0.5) / gridSize) * 255.0 + 0.5);
 
-	// last part of string if it does not end with a space
-	if(start != str.end())
-		sub(str.end());
+	if(texel.a < 0.5)
+		discard;
 
-	return ret;
+	vec2 glyph = vec2(texel.r, texel.g + texel.b * 256.0);
+	vec4 color = texture2D(palette, vec2((texel.a - 0.5) / 256.0, 0.5));
+
+	gl_FragColor = texture2D(atlas, (glyph + fract(cell)) / atlasGlyphs) * color;
 }
+)";
 
 namespace dbr
 {
@@ -53,21 +55,30 @@ namespace dbr
 		{}
 
 		Console::Console(sf::Vector2u size, sf::Vector2f charScale, const sf::String& prompt, const sfml::BitmapFont& font)
-			: entryHandler{},
+			: ConsoleCore{size, prompt},
 			hasFocus{false},
 			background{0, 0, 0, 230},
 			baseForeground{sf::Color::White},
 			cursorBlinkPeriod{sf::milliseconds(500)},
-			commands{},
 			font{&font},
-			size{size},
-			cells{size.x * size.y},
 			charScale{charScale},
+			palette{},
+			slotRows{},
+			windowDirty{},
+			windowForeground{baseForeground},
+			windowGeneration{font.getGeneration()},
+			renderMode{RenderMode::Vertices},
+			windowVertices{},
+			vertexBuffer{sf::Quads, sf::VertexBuffer::Dynamic},
+			gridTexture{},
+			gridTexels{},
+			paletteTexture{},
+			gridPalette{},
+			gridShader{},
+			gridShaderLoaded{false},
 			contentView{{0, 0, static_cast<float>(size.x * font.getGlyphSize().x * charScale.x), static_cast<float>(size.y * font.getGlyphSize().y * charScale.y)}},
-			cursorIndex{0},
 			cursor{{font.getGlyphSize().x * charScale.x, font.getGlyphSize().y * charScale.y}},
 			backgroundShape{contentView.getSize()},
-			prompt{prompt},
 			drawCursor{false},
 			blinkClock{}
 		{
@@ -75,61 +86,72 @@ namespace dbr
 			backgroundShape.setOutlineColor(baseForeground);
 			backgroundShape.setOutlineThickness(1);
 
-			auto charSize = font.getGlyphSize();
-			auto realSize = sf::Vector2f{charScale.x * charSize.x, charScale.y * charSize.y};
-
-			for(auto i = 0u; i < cells.size(); ++i)
-			{
-				sf::Vector2f topLeft = {static_cast<float>(i % size.x * realSize.x),
-										static_cast<float>(i / size.x * realSize.y)};
-
-				cells[i].setPosition(topLeft);
-				cells[i].setSize(realSize);
-				cells[i].setColor(background);	// background, because characters shouldn't be visible yet
-			}
+			setupWindow();
 
 			cursor.setFillColor(baseForeground);
-
-			addString(prompt);
 		}
 
 		Console::Console(const Console& other)
-			: entryHandler{other.entryHandler},
+			: ConsoleCore{other},
 			hasFocus{other.hasFocus},
 			background{other.background},
 			baseForeground{other.baseForeground},
 			cursorBlinkPeriod{other.cursorBlinkPeriod},
-			commands{other.commands},
-			entryHistory(other.entryHistory),
 			font{other.font},
-			size{other.size},
 			charScale{other.charScale},
+			palette{other.palette},
+			slotRows{},
+			windowDirty{},
+			windowForeground{other.windowForeground},
+			windowGeneration{other.windowGeneration},
+			renderMode{other.renderMode},
+			windowVertices{},
+			vertexBuffer{sf::Quads, sf::VertexBuffer::Dynamic},
+			gridTexture{},
+			gridTexels{},
+			paletteTexture{},
+			gridPalette{},
+			gridShader{},
+			gridShaderLoaded{false},
 			contentView{other.contentView},
 			cursor{other.cursor},
 			backgroundShape{other.backgroundShape},
-			prompt{other.prompt},
 			drawCursor{other.drawCursor},
 			blinkClock{other.blinkClock}
-		{}
+		{
+			setupWindow();
+		}
 
 		Console::Console(Console&& other)
-			: entryHandler{std::move(other.entryHandler)},
+			: ConsoleCore{std::move(other)},
 			hasFocus{other.hasFocus},
 			background{other.background},
 			baseForeground{other.baseForeground},
 			cursorBlinkPeriod{other.cursorBlinkPeriod},
-			commands{std::move(other.commands)},
-			entryHistory(std::move(other.entryHistory)),
 			font{other.font},
-			size{other.size},
 			charScale{other.charScale},
+			palette{std::move(other.palette)},
+			slotRows{},
+			windowDirty{},
+			windowForeground{other.windowForeground},
+			windowGeneration{other.windowGeneration},
+			renderMode{other.renderMode},
+			windowVertices{},
+			vertexBuffer{sf::Quads, sf::VertexBuffer::Dynamic},
+			gridTexture{},
+			gridTexels{},
+			paletteTexture{},
+			gridPalette{},
+			gridShader{},
+			gridShaderLoaded{false},
 			contentView{other.contentView},
 			cursor{other.cursor},
 			backgroundShape{other.backgroundShape},
-			prompt{other.prompt},
 			drawCursor{other.drawCursor},
 			blinkClock{other.blinkClock}
 		{
+			setupWindow();
+
 			other.font = nullptr;
 		}
 
@@ -138,98 +160,46 @@ namespace dbr
 			switch(event.type)
 			{
 				case sf::Event::TextEntered:
-				{
-					// non-printable characters
-					if(event.text.unicode < 0x20 || (0x7F <= event.text.unicode && event.text.unicode <= 0x100))
-					{
-						// check for control characters
-						constexpr std::uint32_t BACKSPACE = '\b';
-						constexpr std::uint32_t TAB = '\t';
-						constexpr std::uint32_t NEW_LINE = '\n';
-						constexpr std::uint32_t CARR_RETURN = '\r';
-
-						switch(event.text.unicode)
-						{
-							case BACKSPACE:
-							{
-								// delete character previous to buffer index and move index back by 1
-								auto buf = bufferIndex();
-								if(buf > 0)
-									deleteAt(buf - 1);
-
-								break;
-							}
-
-							case TAB:
-								// auto-complete
-
-								break;
-
-							case NEW_LINE:
-							case CARR_RETURN:
-							{
-								cursorAt(nextLine());
-
-								addHistory(buffer);
-
-								// submit buffer as command
-								if(!run(buffer))
-									addString("Command does not exist\n");
-
-								buffer.clear();
-								newPrompt();
-
-								break;
-							}
-
-							default:
-								break;
-						}
-					}
-					else
-					{
-						// printable character. add to current buffer
-
-						buffer += event.text.unicode;
-						addChar(event.text.unicode);
-					}
-
+					input(event.text.unicode);
 					break;
-				}
 
 				case sf::Event::KeyReleased:
 					switch(event.key.code)
 					{
 						case sf::Keyboard::Up:
-							if(historyIndex > 0)
-								--historyIndex;
-							useHistory();
+							input(Key::Up);
 							break;
 
 						case sf::Keyboard::Down:
-							if(historyIndex < entryHistory.size() - 1)
-								++historyIndex;
-							useHistory();
+							input(Key::Down);
 							break;
 
 						case sf::Keyboard::Left:
-							bufferIndex(bufferIndex() - 1);
+							input(Key::Left);
 							break;
 
 						case sf::Keyboard::Right:
-							bufferIndex(bufferIndex() + 1);
+							input(Key::Right);
 							break;
 
 						case sf::Keyboard::Home:
-							bufferIndex(0);
+							input(Key::Home);
 							break;
 
 						case sf::Keyboard::End:
-							bufferIndex(buffer.getSize());
+							input(Key::End);
 							break;
 
 						case sf::Keyboard::Delete:
-							deleteAt(bufferIndex());
+							input(Key::Delete);
+							break;
+
+						case sf::Keyboard::PageUp:
+							input(Key::PageUp);
+							break;
+
+						case sf::Keyboard::PageDown:
+							input(Key::PageDown);
 							break;
 
 						default:
@@ -237,48 +207,38 @@ namespace dbr
 					}
 					break;
 
+				case sf::Event::MouseWheelScrolled:
+					if(event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel)
+						scroll(static_cast<int>(event.mouseWheelScroll.delta * WHEEL_ROWS));
+					break;
+
 				default:
 					break;
 			}
 		}
 
-		void Console::clear()
+		void Console::setTextColor(sf::Color color)
 		{
-			buffer.clear();
+			auto it = std::find(palette.begin(), palette.end(), color);
 
-			for(auto& c : cells)
+			if(it != palette.end())
 			{
-				c.setColor(background);
-				c.setTexCoord({0, 0, 0, 0});
+				getGrid().setAttribute(static_cast<sf::Uint32>(it - palette.begin()) + 1);
 			}
-
-			cursorAt(0);
-		}
-
-		void Console::addCommand(const sf::String& name, Command&& command)
-		{
-			commands.emplace(name, command);
-		}
-
-		bool Console::run(const sf::String& entry)
-		{
-			auto args = split(entry, ' ');
-
-			if(!args.empty())
+			else if(palette.size() < MAX_COLORS)
 			{
-				auto it = commands.find(args.front());
-
-				if(it != commands.end())
-					it->second(args);
-				else if(args.front() == "clear")
-					clear();
-				else if(entryHandler)
-					entryHandler(entry);
-				else
-					return false;
+				palette.push_back(color);
+				getGrid().setAttribute(static_cast<sf::Uint32>(palette.size()));
+			}
+			else
+			{
+				getGrid().setAttribute(0);
 			}
+		}
 
-			return true;
+		void Console::resetTextColor()
+		{
+			getGrid().setAttribute(0);
 		}
 
 		const sfml::BitmapFont* Console::getFont() const
@@ -288,126 +248,104 @@ namespace dbr
 
 		void Console::setFont(const sfml::BitmapFont& font)
 		{
-			auto charSize = font.getGlyphSize();
-
-			auto width = static_cast<float>(size.x * charScale.x * charSize.x);
-			auto height = static_cast<float>(size.y * charScale.y * charSize.y);
-			contentView.reset({0.f, 0.f, width, height});
-
-			backgroundShape.setSize(contentView.getSize());
-
 			this->font = &font;
-		}
 
-		std::size_t Console::cursorAt() const
-		{
-			return cursorIndex;
+			// cells only hold code points, so redrawing the window is enough to pick up the new glyphs
+			setupSizes();
+			setupWindow();
 		}
 
-		void Console::cursorAt(std::size_t idx)
+		void Console::setSize(sf::Vector2u size)
 		{
-			cursorIndex = idx;
+			ConsoleCore::setSize(size);
 
-			auto charSize = font->getGlyphSize();
-			cursor.setPosition(cursorIndex % size.x * charScale.x * charSize.x, cursorIndex / size.x * charScale.y * charSize.y);
+			setupSizes();
+			setupWindow();
 		}
 
-		void Console::addChar(sf::Uint32 unicode)
+		sf::Vector2f Console::getPixelSize() const
 		{
-			if(unicode == '\n')
-			{
-				cursorAt(nextLine());
-			}
-			else
-			{
-				// don't mess with spaces
-				if(unicode != ' ')
-				{
-					// check for reaching end of screen
-					if(cursorIndex >= size.x * size.y)
-						clear();
-
-					auto charSize = static_cast<sf::Vector2f>(font->getGlyphSize());
-					auto& glyph = font->getTextureCoord(unicode);
-
-					cells[cursorIndex].setTexCoord({static_cast<float>(glyph.x), static_cast<float>(glyph.y), charSize.x, charSize.y});
-					cells[cursorIndex].setColor(baseForeground);
-				}
-
-				cursorAt(cursorIndex + 1);
-			}
+			return backgroundShape.getSize();
 		}
 
-		void Console::addString(const sf::String& str)
+		void Console::setPixelSize(sf::Vector2f size)
 		{
-			for(auto u : str)
-				addChar(u);
-		}
+			auto charSize = font->getGlyphSize();
 
-		void Console::clearBuffer()
-		{
-			bufferIndex(0);
+			auto columns = static_cast<unsigned int>(std::max(size.x / (charScale.x * charSize.x), 1.f));
+			auto rows = static_cast<unsigned int>(std::max(size.y / (charScale.y * charSize.y), 1.f));
 
-			for(auto i = 0u; i < buffer.getSize(); ++i)
-			{
-				cells[cursorIndex + i].setTexCoord({0.f, 0.f, 0.f, 0.f});
-				cells[cursorIndex + i].setColor(background);
-			}
+			setSize({columns, rows});
 		}
 
-		void Console::deleteAt(std::size_t bufIdx)
+		Console::RenderMode Console::getRenderMode() const
 		{
-			if(!buffer.isEmpty() && bufIdx < buffer.getSize())
-			{
-				clearBuffer();
-				buffer.erase(bufIdx);
-				addString(buffer);
-				bufferIndex(bufIdx);
-			}
+			return renderMode;
 		}
 
-		std::size_t Console::bufferIndex()
+		void Console::setRenderMode(RenderMode mode)
 		{
-			return cursorIndex % size.x - prompt.getSize();
-		}
+			auto& size = getGrid().getSize();
 
-		void Console::bufferIndex(std::size_t idx)
-		{
-			if(idx <= buffer.getSize())
-				cursorAt(cursorIndex + idx - bufferIndex());
-		}
+			renderMode = mode;
 
-		std::size_t Console::nextLine()
-		{
-			return cursorIndex + size.x - cursorIndex % size.x;
+			// the other mode's copy of the window is stale
+			TextGrid::addSpan(windowDirty, 0, size.x * size.y);
 		}
 
-		void Console::newPrompt()
+		std::size_t Console::getMemoryUsage() const
 		{
-			addString(prompt);
-			buffer.clear();
+			return getGrid().getMemoryUsage()
+				+ slotRows.capacity() * sizeof(std::size_t)
+				+ windowVertices.capacity() * sizeof(sf::Vertex)
+				+ gridTexels.capacity();
 		}
 
 		void Console::setupSizes()
 		{
+			auto& size = getGrid().getSize();
+			auto charSize = font->getGlyphSize();
 
-		}
+			auto width = static_cast<float>(size.x * charScale.x * charSize.x);
+			auto height = static_cast<float>(size.y * charScale.y * charSize.y);
+			contentView.reset({0.f, 0.f, width, height});
 
-		void Console::addHistory(const sf::String& str)
-		{
-			entryHistory.push_back(buffer);
-			historyIndex = entryHistory.size();
+			backgroundShape.setSize(contentView.getSize());
+			cursor.setSize({charScale.x * charSize.x, charScale.y * charSize.y});
 		}
 
-		void Console::useHistory()
+		void Console::setupWindow()
 		{
-			clearBuffer();
-			buffer = historyIndex < entryHistory.size() ? entryHistory[historyIndex] : "";
-			addString(buffer);
+			auto& size = getGrid().getSize();
+			auto charSize = font->getGlyphSize();
+			auto realSize = sf::Vector2f{charScale.x * charSize.x, charScale.y * charSize.y};
+
+			windowVertices.resize(size.x * size.y * 4);
+
+			// slots are laid out top to bottom. draw() translates them into place
+			for(auto i = 0u; i < size.x * size.y; ++i)
+			{
+				sf::Vector2f topLeft = {static_cast<float>(i % size.x * realSize.x),
+										static_cast<float>(i / size.x * realSize.y)};
+
+				auto* quad = &windowVertices[i * 4];
+				quad[0].position = topLeft;
+				quad[1].position = topLeft + sf::Vector2f{realSize.x, 0};
+				quad[2].position = topLeft + realSize;
+				quad[3].position = topLeft + sf::Vector2f{0, realSize.y};
+			}
+
+			slotRows.assign(size.y, NO_ROW);
+			windowDirty.clear();
 		}
 
 		void Console::draw(sf::RenderTarget& target, sf::RenderStates states) const
 		{
+#ifdef DBR_CNSL_STATS
+			sf::Clock clock;
+			frameVertices = 4;	// the background. Shapes count as the quad they are
+#endif
+
 			states.transform *= getTransform();
 			target.draw(backgroundShape, states);
 
@@ -422,16 +360,34 @@ namespace dbr
 
 			target.setView(contentView);
 
-			states.texture = &font->getTexture();
+			syncWindow();
 
-			// this cast is safe to do, since a Cell is just 4 sf::Vertex, and cells is contiguous memory
-			target.draw(reinterpret_cast<const sf::Vertex*>(cells.data()), cells.size() * 4, sf::PrimitiveType::Quads, states);
+			if(renderMode != RenderMode::Shader || !drawGrid(target, states))
+				drawVertices(target, states);
 
-			if(drawCursor)
-				target.draw(cursor, states);
+			auto& grid = getGrid();
+
+			if(drawCursor && grid.getScrollOffset() == 0)
+			{
+				auto cursorIndex = grid.getCursor();
+				auto cellSize = cursor.getSize();
+
+				auto cursorStates = states;
+				cursorStates.transform.translate(cursorIndex % grid.getSize().x * cellSize.x, cursorIndex / grid.getSize().x * cellSize.y);
+
+				target.draw(cursor, cursorStates);
+
+#ifdef DBR_CNSL_STATS
+				frameVertices += 4;
+#endif
+			}
 
 			target.setView(prevView);
 
+#ifdef DBR_CNSL_STATS
+			recordDraw(clock.getElapsedTime(), frameVertices);
+#endif
+
 			if(blinkClock.getElapsedTime() >= cursorBlinkPeriod)
 			{
 				drawCursor = !drawCursor;
@@ -439,67 +395,284 @@ namespace dbr
 			}
 		}
 
-		void Console::Cell::setColor(sf::Color color)
+		void Console::syncWindow() const
 		{
-			for(auto& v : vertices)
-				v.color = color;
+			auto& grid = getGrid();
+			auto& size = grid.getSize();
+
+			// colors and glyph coordinates are baked into the window, so a new baseForeground,
+			// or glyphs evicted from the font (by another drawable), means rebuilding it
+			if(windowForeground != baseForeground || windowGeneration != font->getGeneration())
+			{
+				slotRows.assign(size.y, NO_ROW);
+				windowForeground = baseForeground;
+				windowGeneration = font->getGeneration();
+			}
+
+			// scrolling moves rows into slots. Rows already in their slot are left alone
+			auto top = grid.viewTop();
+
+			for(auto i = 0u; i < size.y; ++i)
+			{
+				auto row = (top + i) % grid.getScrollbackSize();
+				auto slot = row % size.y;
+
+				if(slotRows[slot] != row)
+				{
+					slotRows[slot] = row;
+					TextGrid::addSpan(windowDirty, slot * size.x, size.x);
+				}
+			}
+
+			// changed cells only matter if their row is in view
+			for(auto& d : grid.getDirty())
+			{
+				for(auto first = d.first; first < d.last;)
+				{
+					auto row = first / size.x;
+					auto last = std::min(d.last, (row + 1) * size.x);
+					auto slot = row % size.y;
+
+					if(slotRows[slot] == row)
+						TextGrid::addSpan(windowDirty, slot * size.x + first % size.x, last - first);
+
+					first = last;
+				}
+			}
+
+			grid.clearDirty();
 		}
 
-		void Console::Cell::setPosition(sf::Vector2f pos)
+		sf::Color Console::colorOf(sf::Uint32 attribute) const
 		{
-			for(int i = vertices.size() - 1; i > 0; --i)
-				vertices[i].position += (pos - vertices[0].position);
-			vertices[0].position = pos;
+			return attribute != 0 && attribute <= palette.size() ? palette[attribute - 1] : baseForeground;
 		}
 
-		void Console::Cell::setSize(sf::Vector2f size)
+		const Console::Cell& Console::slotCell(std::size_t slotIdx) const
 		{
-			vertices[1].position = vertices[0].position + sf::Vector2f{size.x, 0};
-			vertices[2].position = vertices[0].position + size;
-			vertices[3].position = vertices[0].position + sf::Vector2f{0, size.y};
+			auto width = getGrid().getSize().x;
+
+			return getGrid().getRow(slotRows[slotIdx / width])[slotIdx % width];
 		}
 
-		void Console::Cell::setTexCoord(sf::FloatRect rect)
+		void Console::drawVertices(sf::RenderTarget& target, sf::RenderStates states) const
 		{
-			vertices[0].texCoords = {rect.left, rect.top};
-			vertices[1].texCoords = {rect.left + rect.width, rect.top};
-			vertices[2].texCoords = {rect.left + rect.width, rect.top + rect.height};
-			vertices[3].texCoords = {rect.left, rect.top + rect.height};
+			auto& size = getGrid().getSize();
+
+			auto glyphSize = static_cast<sf::Vector2f>(font->getGlyphSize());
+			auto buffered = sf::VertexBuffer::isAvailable();
+
+			if(buffered && vertexBuffer.getVertexCount() != windowVertices.size())
+			{
+				vertexBuffer.create(windowVertices.size());
+				windowDirty.assign(1, {0, size.x * size.y});
+			}
+
+			updateVertices(buffered);
+
+			// rasterizing new glyphs can evict ones still shown outside the dirty spans. So rebuild all of it, which
+			// only evicts glyphs it doesn't show, as every glyph it shows is then more recently used
+			if(windowGeneration != font->getGeneration())
+			{
+				windowDirty.assign(1, {0, size.x * size.y});
+				updateVertices(buffered);
+
+				windowGeneration = font->getGeneration();
+			}
+
+			// the glyphs rasterized for a font loaded with loadFromFont() are only in its texture after this
+			states.texture = &font->getTexture();
+
+			// slots hold the view starting from the top row's slot, wrapping past the last slot
+			auto rowHeight = charScale.y * glyphSize.y;
+			auto topSlot = getGrid().viewTop() % size.y;
+
+			drawSlots(target, states, topSlot, size.y - topSlot, -static_cast<float>(topSlot) * rowHeight);
+
+			if(topSlot > 0)
+				drawSlots(target, states, 0, topSlot, static_cast<float>(size.y - topSlot) * rowHeight);
 		}
-	}
-}
 
-namespace std
-{
-	std::size_t hash<sf::String>::operator()(const sf::String& s) const
-	{
-		// FNV-1a hash (values for "prime" and "offset" from: www.isthe.com/chongo/tech/comp/fnv/#FNV-param)
-		// (2 power of x) == 2 << (x - 1)
-
-		// using the architecture detection used by nothings' stb libraries (www.github.com/nothings/stb)
-#if defined(__x86_64__) || defined(_M_X64)
-		// 64 bit
-		constexpr std::size_t prime = (2u << 39) + (2u << 7) + 0xb3u;
-		constexpr std::size_t offset = 14695981039346656037u;
-#elif defined(__i386) || defined(_M_IX86)
-		// 32 bit
-		constexpr std::size_t prime = (2u << 23) + (2u << 7) + 0x93u;
-		constexpr std::size_t offset = 2166136261u;
-#else
-#	error This sf::String hash is only implemented for x86 or x64 architectures
-#endif
+		void Console::updateVertices(bool buffered) const
+		{
+			auto glyphSize = static_cast<sf::Vector2f>(font->getGlyphSize());
+
+			for(auto& d : windowDirty)
+			{
+				for(auto i = d.first; i < d.last; ++i)
+				{
+					auto& cell = slotCell(i);
+					auto* quad = &windowVertices[i * 4];
+
+					if(cell.codePoint == TextGrid::EMPTY_CELL)
+					{
+						for(auto v = 0u; v < 4; ++v)
+						{
+							quad[v].texCoords = {0.f, 0.f};
+							quad[v].color = sf::Color::Transparent;
+						}
+					}
+					else
+					{
+						auto texCoord = static_cast<sf::Vector2f>(font->getTextureCoord(cell.codePoint));
+						auto color = colorOf(cell.attribute);
+
+						quad[0].texCoords = texCoord;
+						quad[1].texCoords = texCoord + sf::Vector2f{glyphSize.x, 0};
+						quad[2].texCoords = texCoord + glyphSize;
+						quad[3].texCoords = texCoord + sf::Vector2f{0, glyphSize.y};
+
+						for(auto v = 0u; v < 4; ++v)
+							quad[v].color = color;
+					}
+				}
+
+				if(buffered)
+					vertexBuffer.update(&windowVertices[d.first * 4], (d.last - d.first) * 4, static_cast<unsigned int>(d.first * 4));
+			}
 
-		auto* ptr = reinterpret_cast<const std::uint8_t*>(s.getData());
-		auto* end = ptr + s.getSize() * sizeof(sf::Uint32);
+			windowDirty.clear();
+		}
+
+		bool Console::drawGrid(sf::RenderTarget& target, sf::RenderStates states) const
+		{
+			auto& size = getGrid().getSize();
+			auto& atlas = font->getTexture();
+			auto glyphSize = font->getGlyphSize();
+			auto maxSize = sf::Texture::getMaximumSize();
+
+			// a glyph's atlas column has to fit in one byte of its texel
+			if(!sf::Shader::isAvailable() || size.x > maxSize || size.y > maxSize || atlas.getSize().x / glyphSize.x > 256)
+				return false;
+
+			if(!gridShaderLoaded)
+			{
+				if(!gridShader.loadFromMemory(GRID_FRAGMENT_SHADER, sf::Shader::Fragment))
+					return false;
+
+				gridShaderLoaded = true;
+			}
+
+			auto gridSize = gridTexture.getSize();
+
+			if(gridSize.x != size.x || gridSize.y != size.y)
+			{
+				if(!gridTexture.create(size.x, size.y))
+					return false;
+
+				gridTexels.assign(size.x * size.y * 4, 0);
+				windowDirty.assign(1, {0, size.x * size.y});
+			}
+
+			if(paletteTexture.getSize().x != MAX_COLORS + 2)
+			{
+				if(!paletteTexture.create(MAX_COLORS + 2, 1))
+					return false;
+
+				gridPalette.clear();
+			}
+
+			// texel n of the palette is the color of attribute n
+			if(gridPalette.size() != palette.size() + 1 || gridPalette[0] != baseForeground || !std::equal(palette.begin(), palette.end(), gridPalette.begin() + 1))
+			{
+				gridPalette.assign(1, baseForeground);
+				gridPalette.insert(gridPalette.end(), palette.begin(), palette.end());
+
+				paletteTexture.update(reinterpret_cast<const sf::Uint8*>(gridPalette.data()), static_cast<unsigned int>(gridPalette.size()), 1, 0, 0);
+			}
+
+			uploadGrid();
+
+			// as in drawVertices()
+			if(windowGeneration != font->getGeneration())
+			{
+				windowDirty.assign(1, {0, size.x * size.y});
+				uploadGrid();
+
+				windowGeneration = font->getGeneration();
+			}
+
+			// the glyphs rasterized for a font loaded with loadFromFont() are only in its texture after this
+			gridShader.setUniform("atlas", font->getTexture());
+			gridShader.setUniform("grid", gridTexture);
+			gridShader.setUniform("palette", paletteTexture);
+			gridShader.setUniform("gridSize", sf::Glsl::Vec2{static_cast<float>(size.x), static_cast<float>(size.y)});
+			gridShader.setUniform("atlasGlyphs", sf::Glsl::Vec2{static_cast<float>(atlas.getSize().x) / glyphSize.x, static_cast<float>(atlas.getSize().y) / glyphSize.y});
+			gridShader.setUniform("topRow", static_cast<float>(getGrid().viewTop() % size.y));
 
-		std::size_t val = offset;
+			auto quadSize = contentView.getSize();
 
-		for(; ptr != end; ++ptr)
+			const sf::Vertex quad[4] =
+			{
+				{{0.f, 0.f}, {0.f, 0.f}},
+				{{quadSize.x, 0.f}, {1.f, 0.f}},
+				{quadSize, {1.f, 1.f}},
+				{{0.f, quadSize.y}, {0.f, 1.f}},
+			};
+
+			states.shader = &gridShader;
+			target.draw(quad, 4, sf::PrimitiveType::Quads, states);
+
+#ifdef DBR_CNSL_STATS
+			frameVertices += 4;
+#endif
+
+			return true;
+		}
+
+		void Console::uploadGrid() const
 		{
-			val ^= *ptr;
-			val *= prime;
+			auto& size = getGrid().getSize();
+			auto glyphSize = font->getGlyphSize();
+
+			for(auto& d : windowDirty)
+			{
+				for(auto i = d.first; i < d.last; ++i)
+				{
+					auto& cell = slotCell(i);
+					auto* texel = &gridTexels[i * 4];
+
+					if(cell.codePoint == TextGrid::EMPTY_CELL)
+					{
+						texel[3] = 0;
+					}
+					else
+					{
+						auto texCoord = font->getTextureCoord(cell.codePoint);
+						auto column = texCoord.x / glyphSize.x;
+						auto row = texCoord.y / glyphSize.y;
+
+						texel[0] = static_cast<sf::Uint8>(column);
+						texel[1] = static_cast<sf::Uint8>(row & 0xff);
+						texel[2] = static_cast<sf::Uint8>(row >> 8);
+						texel[3] = static_cast<sf::Uint8>(cell.attribute + 1);
+					}
+				}
+
+				// texture updates are rectangles, so upload the whole rows covering the span
+				auto firstRow = d.first / size.x;
+				auto lastRow = (d.last + size.x - 1) / size.x;
+
+				gridTexture.update(&gridTexels[firstRow * size.x * 4], size.x, static_cast<unsigned int>(lastRow - firstRow), 0, static_cast<unsigned int>(firstRow));
+			}
+
+			windowDirty.clear();
 		}
 
-		return val;
+		void Console::drawSlots(sf::RenderTarget& target, sf::RenderStates states, std::size_t firstSlot, std::size_t numSlots, float offset) const
+		{
+			auto& size = getGrid().getSize();
+
+			states.transform.translate(0.f, offset);
+
+			if(sf::VertexBuffer::isAvailable())
+				target.draw(vertexBuffer, firstSlot * size.x * 4, numSlots * size.x * 4, states);
+			else
+				target.draw(&windowVertices[firstSlot * size.x * 4], numSlots * size.x * 4, sf::PrimitiveType::Quads, states);
+
+#ifdef DBR_CNSL_STATS
+			frameVertices += numSlots * size.x * 4;
+#endif
+		}
 	}
 }
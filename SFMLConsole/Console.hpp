@@ -2,17 +2,19 @@
 #define DBR_CNSL_CONSOLE_HPP
 
 #include <vector>
-#include <array>
-#include <unordered_map>
-#include <functional>
 
 #include <SFML/Graphics/View.hpp>
 #include <SFML/Graphics/Text.hpp>
 #include <SFML/Graphics/RectangleShape.hpp>
+#include <SFML/Graphics/VertexBuffer.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Shader.hpp>
 
 #include <SFML/System/Clock.hpp>
 #include <SFML/System/Time.hpp>
 
+#include "ConsoleCore.hpp"
+
 // forward declarations
 namespace sf
 {
@@ -27,29 +29,20 @@ namespace dbr
 	}
 }
 
-// std::hash for SFML's String class
-namespace std
-{
-	template<>
-	struct hash<sf::String>
-	{
-		std::size_t operator()(const sf::String& s) const;
-	};
-}
-
 namespace dbr
 {
 	namespace cnsl
 	{
-		class Console;
-
-		using Args = std::vector<sf::String>;
-		using Command = std::function<void(const Args& args)>;
-		using EntryHandler = std::function<void(const sf::String&)>;
-
-		class Console : public sf::Drawable, public sf::Transformable
+		// draws a ConsoleCore with a BitmapFont, and feeds it SFML's input events
+		class Console : public ConsoleCore, public sf::Drawable, public sf::Transformable
 		{
 		public:
+			enum class RenderMode
+			{
+				Vertices,	// 4 vertices per cell, uploaded as they change
+				Shader,		// one quad. A fragment shader looks up each cell's glyph in a texture with one texel per cell
+			};
+
 			Console(const sfml::BitmapFont& font);
 			Console(const sf::String& prompt, const sfml::BitmapFont& font);
 
@@ -66,29 +59,34 @@ namespace dbr
 
 			/* actions */
 
-			void update(const sf::Event& event);
-			void clear();
-
-			void addCommand(const sf::String& name, Command&& command);
+			using ConsoleCore::update;
 
-			// returns true/false command does/doesn't exist
-			bool run(const sf::String& entry);
+			void update(const sf::Event& event);
 
-			template<typename T>
-			Console& operator<<(const T& t);
+			// output written after this is drawn in color, instead of baseForeground
+			// up to 254 distinct colors can be used. Past that, output falls back to baseForeground
+			void setTextColor(sf::Color color);
+			void resetTextColor();
 
 			/* properties functions */
 
 			const sfml::BitmapFont* getFont() const;
 			void setFont(const sfml::BitmapFont& font);
 
-			std::size_t cursorAt() const;
-			void cursorAt(std::size_t idx);
+			// size in characters. Output is rewrapped to the new width, see ConsoleCore::setSize()
+			void setSize(sf::Vector2u size);
 
-			// provided if custom input handling is desired (ie: used for providing user access to a scripting language)
-			// Called when an entry does not match a provided command or "clear"
-			// all input is provided as a single argument
-			EntryHandler entryHandler;
+			// size in pixels, before the transform. Set, it is rounded down to whole characters (at least 1 x 1)
+			sf::Vector2f getPixelSize() const;
+			void setPixelSize(sf::Vector2f size);
+
+			// Shader falls back to Vertices if shaders aren't available, the console is larger
+			// than the max texture size, or the font atlas is more than 256 glyphs wide
+			RenderMode getRenderMode() const;
+			void setRenderMode(RenderMode mode);
+
+			// bytes used by the scrollback and the vertices/texels of the visible rows
+			std::size_t getMemoryUsage() const;
 
 			/* data */
 
@@ -100,74 +98,85 @@ namespace dbr
 			sf::Time cursorBlinkPeriod;
 
 		private:
-			struct Cell
-			{
-				std::array<sf::Vertex, 4> vertices;
+			using Cell = TextGrid::Cell;
+			using Span = TextGrid::Span;
 
-				void setColor(sf::Color color);
-				void setPosition(sf::Vector2f pos);
-				void setSize(sf::Vector2f size);
-				void setTexCoord(sf::FloatRect rect);
-			};
+			// sizes the view, background and cursor to the grid and font
+			void setupSizes();
 
-			void addChar(sf::Uint32 unicode);
-			void addString(const sf::String& str);
-			void clearBuffer();
-			void deleteAt(std::size_t bufIdx);
+			// lays out the window slots' vertices, and forgets which rows they hold
+			void setupWindow();
 
-			std::size_t bufferIndex();
-			void bufferIndex(std::size_t idx);
-			std::size_t nextLine();
-			void newPrompt();
+			void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
 
-			void setupSizes();
+			// brings the visible rows into their window slots, and collects the changed slot cells in windowDirty
+			void syncWindow() const;
 
-			void addHistory(const sf::String& str);
-			void useHistory();
+			sf::Color colorOf(sf::Uint32 attribute) const;
+			const Cell& slotCell(std::size_t slotIdx) const;
 
-			void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+			void drawVertices(sf::RenderTarget& target, sf::RenderStates states) const;
+
+			// writes the changed slot cells into windowVertices, and the vertex buffer if buffered
+			void updateVertices(bool buffered) const;
 
-			std::unordered_map<sf::String, Command> commands;
+			// returns false if the grid can't be drawn with the shader
+			bool drawGrid(sf::RenderTarget& target, sf::RenderStates states) const;
 
-			std::vector<sf::String> entryHistory;
-			std::size_t historyIndex;
+			// writes the changed slot cells into gridTexels, and uploads the rows they cover
+			void uploadGrid() const;
+
+			void drawSlots(sf::RenderTarget& target, sf::RenderStates states, std::size_t firstSlot, std::size_t numSlots, float offset) const;
+
+			static constexpr int WHEEL_ROWS = 3;	// rows scrolled per mouse wheel step
+			static constexpr std::size_t NO_ROW = static_cast<std::size_t>(-1);
+			static constexpr std::size_t MAX_COLORS = 254u;	// attributes have to fit in a texel byte, with 0 meaning empty
 
 			const sfml::BitmapFont* font;
-			sf::String buffer;
 
 			// amount to scale a single character by
 			sf::Vector2f charScale;
 
-			// size in characters of the console
-			sf::Vector2u size;
+			// colors of attributes past 0
+			std::vector<sf::Color> palette;
+
+			// only the visible rows are drawn. They are kept in size.y window slots, ring row r in slot r % size.y
+			// the scrollback is a multiple of size.y rows, so the visible rows always fall in distinct slots,
+			// and scrolling by a row only rebuilds one slot. slotRows holds the ring row in each slot
+			mutable std::vector<std::size_t> slotRows;
+			mutable std::vector<Span> windowDirty;
+			mutable sf::Color windowForeground;
+			mutable std::size_t windowGeneration;	// font's getGeneration() the window's glyphs are from
+
+			RenderMode renderMode;
 
-			// text drawing container
-			std::vector<Cell> cells;
+			// RenderMode::Vertices data, 4 per slot cell, and their GPU copy
+			mutable std::vector<sf::Vertex> windowVertices;
+			mutable sf::VertexBuffer vertexBuffer;
+
+			// RenderMode::Shader data. gridTexture has a texel per slot cell:
+			// r = glyph column in the font atlas, g/b = glyph row (low/high byte), a = attribute + 1, or 0 if empty
+			mutable sf::Texture gridTexture;
+			mutable std::vector<sf::Uint8> gridTexels;
+			mutable sf::Texture paletteTexture;
+			mutable std::vector<sf::Color> gridPalette;
+			mutable sf::Shader gridShader;
+			mutable bool gridShaderLoaded;
 
 			// content transformations
 			mutable sf::View contentView;
 
-			std::size_t cursorIndex;
 			sf::RectangleShape cursor;
 
 			sf::RectangleShape backgroundShape;
 
-			sf::String prompt;
-
 			mutable bool drawCursor;
 			mutable sf::Clock blinkClock;
-		};
-
-		template<typename T>
-		Console& Console::operator<<(const T& t)
-		{
-			std::ostringstream oss;
-			oss << t;
-
-			addString(oss.str());
 
-			return *this;
-		}
+#ifdef DBR_CNSL_STATS
+			mutable std::size_t frameVertices{0};	// submitted so far by the current draw()
+#endif
+		};
 	}
 }
 
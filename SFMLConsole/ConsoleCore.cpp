@@ -0,0 +1,1308 @@
+#include "ConsoleCore.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <exception>
+#include <string>
+#include <iomanip>
+#include <cstring>
+#include <fstream>
+
+#include <SFML/System/Utf.hpp>
+
+#include "MappedFile.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		namespace
+		{
+			// the first word of entry
+			StringView nameOf(const sf::String& entry)
+			{
+				auto* data = entry.getData();
+				auto* first = std::find_if_not(data, data + entry.getSize(), Tokenizer::isSpace);
+				auto* last = std::find_if(first, data + entry.getSize(), Tokenizer::isSpace);
+
+				return{first, static_cast<std::size_t>(last - first)};
+			}
+
+			// appends the UTF-8 in [first, last) to text
+			void decodeUtf8(const char* first, const char* last, std::basic_string<sf::Uint32>& text)
+			{
+				while(first != last)
+				{
+					// scripts are mostly ASCII
+					auto byte = static_cast<unsigned char>(*first);
+
+					if(byte < 0x80)
+					{
+						text += byte;
+						++first;
+					}
+					else
+					{
+						sf::Uint32 c;
+						first = sf::Utf8::decode(first, last, c);
+						text += c;
+					}
+				}
+			}
+
+			// counts a level of nesting for its lifetime, so a command throwing out of it still leaves it
+			struct DepthGuard
+			{
+				explicit DepthGuard(std::size_t& depth)
+					: depth{depth}
+				{
+					++depth;
+				}
+
+				~DepthGuard()
+				{
+					--depth;
+				}
+
+				DepthGuard(const DepthGuard&) = delete;
+				DepthGuard& operator=(const DepthGuard&) = delete;
+
+				std::size_t& depth;
+			};
+		}
+
+		Args split(const sf::String& str, sf::Uint32 splitOn)
+		{
+			Args ret;
+
+			auto start = str.begin();
+
+			auto sub = [&](auto last)
+			{
+				auto off = std::distance(str.begin(), start);
+				auto len = std::distance(start, last);
+
+				if(len != 0)
+					ret.emplace_back(str.substring(off, len));
+			};
+
+			for(auto it = start; it != str.end(); ++it)
+			{
+				if(*it == splitOn)
+				{
+					sub(it);
+					start = std::next(it);
+				}
+			}
+
+			// last part of string if it does not end with a space
+			if(start != str.end())
+				sub(str.end());
+
+			return ret;
+		}
+
+		const ConsoleCore::Builtin ConsoleCore::BUILTINS[] =
+		{
+			{"clear", &ConsoleCore::clearCommand},
+			{"tasks", &ConsoleCore::tasksCommand},
+			{"set", &ConsoleCore::setCommand},
+			{"get", &ConsoleCore::getCommand},
+			{"list", &ConsoleCore::listCommand},
+			{"exec", &ConsoleCore::execCommand},
+#ifdef DBR_CNSL_STATS
+			{"stats", &ConsoleCore::statsCommand},
+#endif
+		};
+
+		ConsoleCore::ConsoleCore(sf::Vector2u size, const sf::String& prompt)
+			: entryHandler{},
+			drainLimit{DEFAULT_DRAIN_LIMIT},
+			workerCount{DEFAULT_WORKER_COUNT},
+			frameSlice{sf::microseconds(DEFAULT_FRAME_SLICE)},
+			commands{makeCommands()},
+			tokenizers{},
+			runDepth{0},
+			execDepth{0},
+			outputSink{nullptr},
+			pending{new MessageQueue<sf::String>{DEFAULT_QUEUE_SIZE}},
+			jobs{},
+			shownJobs{0},
+			workers{},
+			grid{size, DEFAULT_SCROLLBACK},
+			editor{prompt},
+			flood{},
+			completions{},
+			completionIndex{0}
+		{
+			editor.begin(grid);
+		}
+
+		ConsoleCore::ConsoleCore(const ConsoleCore& other)
+			: entryHandler{other.entryHandler},
+			drainLimit{other.drainLimit},
+			workerCount{other.workerCount},
+			frameSlice{other.frameSlice},
+			commands{other.commands},
+			tokenizers{},
+			runDepth{0},
+			execDepth{0},
+			outputSink{nullptr},
+			// a moved from console has no queue left
+			pending{new MessageQueue<sf::String>{other.pending ? other.pending->capacity() : DEFAULT_QUEUE_SIZE}},
+			jobs{},
+			shownJobs{0},
+			workers{},
+			grid{other.grid},
+			editor{other.editor},
+			flood{other.flood},
+			completions{},
+			completionIndex{0}
+		{}
+
+		ConsoleCore::ConsoleCore(ConsoleCore&& other)
+			: entryHandler{std::move(other.entryHandler)},
+			drainLimit{other.drainLimit},
+			workerCount{other.workerCount},
+			frameSlice{other.frameSlice},
+			commands{std::move(other.commands)},
+			tokenizers{},
+			runDepth{0},
+			execDepth{0},
+			outputSink{nullptr},
+			pending{std::move(other.pending)},
+			jobs{std::move(other.jobs)},
+			shownJobs{other.shownJobs},
+			workers{std::move(other.workers)},
+			grid{std::move(other.grid)},
+			editor{std::move(other.editor)},
+			flood{std::move(other.flood)},
+			completions{},
+			completionIndex{0}
+		{
+			started = other.started;
+
+#ifdef DBR_CNSL_COROUTINES
+			tasks = std::move(other.tasks);
+			nextTask = other.nextTask;
+#endif
+		}
+
+		ConsoleCore::~ConsoleCore()
+		{
+			for(auto& job : jobs)
+				job.cancel();
+
+			workers.reset();
+		}
+
+		void ConsoleCore::input(sf::Uint32 unicode)
+		{
+			// any input returns the view to the live screen
+			grid.scroll(-static_cast<int>(grid.getScrollOffset()));
+
+			if(unicode != '\t')
+				completions.clear();
+
+			// non-printable characters
+			if(unicode < 0x20 || (0x7F <= unicode && unicode <= 0x100))
+			{
+				// check for control characters
+				constexpr std::uint32_t END_OF_TEXT = 0x03;	// Ctrl+C
+				constexpr std::uint32_t BACKSPACE = '\b';
+				constexpr std::uint32_t TAB = '\t';
+				constexpr std::uint32_t NEW_LINE = '\n';
+				constexpr std::uint32_t CARR_RETURN = '\r';
+
+				switch(unicode)
+				{
+					case BACKSPACE:
+					{
+						// delete character previous to buffer index and move index back by 1
+						auto idx = editor.getIndex();
+						if(idx > 0)
+							editor.erase(grid, idx - 1);
+
+						break;
+					}
+
+					case TAB:
+						complete();
+						break;
+
+					case END_OF_TEXT:
+						cancel();
+						break;
+
+					case NEW_LINE:
+					case CARR_RETURN:
+					{
+						// submit buffer as command
+						auto ran = static_cast<bool>(run(editor.submit(grid)));
+						flood.flush(grid);
+
+						if(!ran)
+							grid.write("Command does not exist\n");
+
+						editor.setStatus(jobStatus());
+						shownJobs = runningCount();
+
+						editor.begin(grid);
+
+						break;
+					}
+
+					default:
+						break;
+				}
+			}
+			else
+			{
+				// printable character. add to current buffer
+				editor.insert(grid, unicode);
+			}
+		}
+
+		void ConsoleCore::input(Key key)
+		{
+			auto rows = static_cast<int>(grid.getSize().y);
+
+			completions.clear();
+
+			switch(key)
+			{
+				case Key::Up:
+					editor.historyPrev(grid);
+					break;
+
+				case Key::Down:
+					editor.historyNext(grid);
+					break;
+
+				case Key::Left:
+					editor.setIndex(grid, editor.getIndex() - 1);
+					break;
+
+				case Key::Right:
+					editor.setIndex(grid, editor.getIndex() + 1);
+					break;
+
+				case Key::Home:
+					editor.setIndex(grid, 0);
+					break;
+
+				case Key::End:
+					editor.setIndex(grid, editor.getSize());
+					break;
+
+				case Key::Delete:
+					editor.erase(grid, editor.getIndex());
+					break;
+
+				case Key::PageUp:
+					grid.scroll(rows - 1);
+					break;
+
+				case Key::PageDown:
+					grid.scroll(1 - rows);
+					break;
+			}
+		}
+
+		void ConsoleCore::update()
+		{
+#ifdef DBR_CNSL_STATS
+			auto elapsed = rateClock.getElapsedTime();
+
+			if(elapsed >= sf::seconds(1.f))
+			{
+				charsPerSecond = (charsWritten - rateStart) / elapsed.asSeconds();
+				rateStart = charsWritten;
+				rateClock.restart();
+			}
+#endif
+
+			auto finished = std::any_of(jobs.begin(), jobs.end(), [](const Job& job) { return !job.isRunning(); });
+			auto waiting = runningCount() != jobs.size();
+
+			if(pending->size() == 0 && !finished && !waiting && shownJobs == runningCount() && flood.isIdle())
+				return;
+
+			// output goes where the prompt was, and the prompt moves below it
+			editor.hide(grid);
+
+			sf::String str;
+
+			// past the flood budget, output waits in the queue, and is dropped there if the queue fills
+			for(auto i = 0u; i < drainLimit && flood.hasBudget() && pending->pop(str); ++i)
+				write(str);
+
+#ifdef DBR_CNSL_COROUTINES
+			runTasks();
+#endif
+
+			if(finished || shownJobs != runningCount())
+			{
+				reapJobs();
+
+				editor.setStatus(jobStatus());
+				shownJobs = runningCount();
+			}
+
+			flood.endFrame(grid);
+
+			editor.show(grid);
+		}
+
+		void ConsoleCore::clear()
+		{
+			editor.reset();
+			grid.clear();
+			flood.reset();
+		}
+
+		void ConsoleCore::scroll(int rows)
+		{
+			grid.scroll(rows);
+		}
+
+		void ConsoleCore::addCommand(const sf::String& name, Command&& command)
+		{
+			// owned arguments are copied out of the views on every call
+			addCommand(name, [command = std::move(command)](ArgsView args)
+			{
+				command(args.toArgs());
+			});
+		}
+
+		void ConsoleCore::addCommand(const sf::String& name, CommandView&& command)
+		{
+			ownCommands().add(name, std::move(command));
+		}
+
+		void ConsoleCore::addCommand(const sf::String& name, AsyncCommand&& command)
+		{
+			ownCommands().add(name, std::move(command));
+		}
+
+		bool ConsoleCore::saveCVars(const std::string& filename) const
+		{
+			std::ofstream out{filename, std::ios::binary};
+
+			if(!out)
+				return false;
+
+			for(auto& name : cvarNames({}))
+			{
+				auto utf8 = name.toUtf8();
+
+				out.write(reinterpret_cast<const char*>(utf8.data()), static_cast<std::streamsize>(utf8.size()));
+				out << ' ' << findCVar(name)->get() << '\n';
+			}
+
+			return static_cast<bool>(out);
+		}
+
+		bool ConsoleCore::loadCVars(const std::string& filename)
+		{
+			std::ifstream in{filename, std::ios::binary};
+
+			if(!in)
+				return false;
+
+			Tokenizer tokenizer;
+			std::string line;
+			std::size_t lineNumber = 0;
+
+			while(std::getline(in, line))
+			{
+				++lineNumber;
+
+				auto entry = sf::String::fromUtf8(line.begin(), line.end());
+				auto args = tokenizer.tokenize(entry);
+
+				if(args.empty() || args.front()[0] == '#')
+					continue;
+
+				auto where = sf::String{filename} + ':' + std::to_string(lineNumber) + ": ";
+				auto* cvar = findCVar(args.front());
+
+				if(args.size() != 2)
+					write(where + "expected \"name value\"\n");
+				else if(!cvar)
+					write(where + "no variable named " + args.front().toString() + '\n');
+				else
+					setCVar(args.front(), *cvar, args[1], where);
+			}
+
+			return true;
+		}
+
+		Job ConsoleCore::run(const sf::String& entry)
+		{
+			return dispatch(entry);
+		}
+
+		Job ConsoleCore::run(const sf::String& entry, const OutputSink& sink)
+		{
+			// nested runs write to the innermost sink
+			auto* previous = outputSink;
+			outputSink = &sink;
+
+			// the local prompt is put aside while it runs, as the entry can still change the grid (a command calling
+			// clear(), say), and is shown again after, with whatever the local user had typed
+			auto prompt = editor.isShown();
+
+			if(prompt)
+				editor.hide(grid);
+
+			try
+			{
+				auto job = dispatch(entry);
+				outputSink = previous;
+
+				if(prompt)
+					editor.show(grid);
+
+				return job;
+			}
+			catch(...)
+			{
+				outputSink = previous;
+
+				if(prompt)
+					editor.show(grid);
+
+				throw;
+			}
+		}
+
+		bool ConsoleCore::exec(const std::string& filename, ExecStats& stats)
+		{
+			stats = {};
+
+			if(execDepth == MAX_EXEC_DEPTH)
+				return false;
+
+			MappedFile file;
+
+			if(!file.open(filename))
+				return false;
+
+			sf::Clock clock;
+
+			auto* it = file.data();
+			auto* end = it + file.size();
+
+			// a batch of entries, back to back, and where each ends
+			std::basic_string<sf::Uint32> text;
+			std::vector<std::size_t> ends;
+
+			text.reserve(EXEC_BATCH);
+
+			// a command throwing out of a script still leaves its depth
+			DepthGuard depth{execDepth};
+
+			while(it != end)
+			{
+				text.clear();
+				ends.clear();
+
+				// a batch is only cut between entries, so a continued entry can go over
+				bool continued = false;
+
+				while(it != end && (continued || text.size() < EXEC_BATCH))
+				{
+					auto* eol = static_cast<const char*>(std::memchr(it, '\n', static_cast<std::size_t>(end - it)));
+					auto* next = eol ? eol + 1 : end;
+					auto* last = eol ? eol : end;
+
+					if(last != it && last[-1] == '\r')
+						--last;
+
+					continued = last != it && last[-1] == '\\';
+
+					decodeUtf8(it, continued ? last - 1 : last, text);
+					++stats.lines;
+
+					if(continued)
+						text += ' ';
+					else
+						ends.push_back(text.size());
+
+					it = next;
+				}
+
+				// a continuation on the last line
+				if(continued)
+					ends.push_back(text.size());
+
+				std::size_t first = 0;
+
+				for(auto last : ends)
+				{
+					StringView entry{text.data() + first, last - first};
+					first = last;
+
+					auto start = std::find_if_not(entry.begin(), entry.end(), Tokenizer::isSpace);
+
+					if(start == entry.end() || *start == '#')
+						continue;
+
+					++stats.entries;
+
+					if(!dispatch(entry))
+						++stats.unknown;
+				}
+			}
+
+			stats.time = clock.getElapsedTime();
+
+			return true;
+		}
+
+		Job ConsoleCore::dispatch(StringView entry)
+		{
+			if(runDepth == tokenizers.size())
+				tokenizers.emplace_back();
+
+			auto args = tokenizers[runDepth].tokenize(entry);
+
+			if(!args.empty())
+			{
+				// kept for the call, so a command adding commands gets a new registry rather than changing this one under itself
+				auto registry = commands;
+				auto* handler = registry->find(args.front());
+
+				// async and coroutine commands print after run() returns, when there's no sink left to take it
+				bool background = handler && handler->async;
+#ifdef DBR_CNSL_COROUTINES
+				background = background || (handler && handler->frame);
+#endif
+
+				if(outputSink && background)
+				{
+					write(args.front().toString() + ": runs in the background, so can't be run remotely\n");
+				}
+				else if(handler && handler->async)
+				{
+					return start(entry.toString(), args.toArgs(), handler->async);
+				}
+#ifdef DBR_CNSL_COROUTINES
+				else if(handler && handler->frame)
+				{
+					start(entry.toString(), args.toArgs(), handler->frame);
+				}
+#endif
+				else if(handler && handler->view)
+				{
+#ifdef DBR_CNSL_STATS
+					sf::Clock clock;
+#endif
+
+					// typed commands throw instead of running with arguments that don't parse
+					try
+					{
+						DepthGuard depth{runDepth};
+						handler->view(args);
+					}
+					catch(const UsageError& error)
+					{
+						write(sf::String::fromUtf8(error.what(), error.what() + std::strlen(error.what())) + "\n");
+					}
+
+#ifdef DBR_CNSL_STATS
+					recordCommand(args.front(), clock.getElapsedTime());
+#endif
+				}
+				else if(handler && handler->cvar)
+				{
+					runCVar(*handler->cvar, args);
+				}
+				else if(auto* builtin = findBuiltin(args.front()))
+				{
+#ifdef DBR_CNSL_STATS
+					sf::Clock clock;
+#endif
+
+					{
+						DepthGuard depth{runDepth};
+						(this->*builtin->run)(args);
+					}
+
+#ifdef DBR_CNSL_STATS
+					recordCommand(args.front(), clock.getElapsedTime());
+#endif
+				}
+				else if(entryHandler)
+				{
+					entryHandler(entry.toString());
+				}
+				else
+				{
+					return{};
+				}
+			}
+
+			return{nullptr, true};
+		}
+
+		void ConsoleCore::cancel()
+		{
+			auto running = std::find_if(jobs.rbegin(), jobs.rend(), [](const Job& job) { return !job.isCancelled(); });
+
+#ifdef DBR_CNSL_COROUTINES
+			// destroying the coroutine unwinds it from the co_await it is waiting at
+			// tasks are kept in the order they started, so the last is the newest
+			if(!tasks.empty() && (running == jobs.rend() || tasks.back().order > running->state->order))
+			{
+				editor.hide(grid);
+				flood.flush(grid);
+				write(tasks.back().stats.entry + ": cancelled\n");
+				editor.show(grid);
+
+				tasks.pop_back();
+				return;
+			}
+#endif
+
+			if(running != jobs.rend())
+			{
+				running->cancel();
+			}
+			else
+			{
+				// held output goes above the prompt, not onto the abandoned entry
+				editor.hide(grid);
+				flood.flush(grid);
+				editor.show(grid);
+
+				editor.setIndex(grid, editor.getSize());
+				grid.write("^C\n");
+				editor.begin(grid);
+			}
+		}
+
+		ConsoleCore& ConsoleCore::operator<<(const sf::String& str)
+		{
+			write(str);
+			return *this;
+		}
+
+		bool ConsoleCore::post(sf::String str)
+		{
+			return pending->push(std::move(str));
+		}
+
+		ConsoleCore::QueueStats ConsoleCore::getQueueStats() const
+		{
+			return{pending->size(), pending->pushed(), pending->dropped(), pending->popped()};
+		}
+
+		const TextGrid& ConsoleCore::getGrid() const
+		{
+			return grid;
+		}
+
+		TextGrid& ConsoleCore::getGrid()
+		{
+			return grid;
+		}
+
+		const LineEditor& ConsoleCore::getEditor() const
+		{
+			return editor;
+		}
+
+		FloodControl& ConsoleCore::getFlood()
+		{
+			return flood;
+		}
+
+		const FloodControl& ConsoleCore::getFlood() const
+		{
+			return flood;
+		}
+
+		const CommandRegistry& ConsoleCore::getCommands() const
+		{
+			return *commands;
+		}
+
+		std::shared_ptr<CommandRegistry> ConsoleCore::shareCommands() const
+		{
+			return commands;
+		}
+
+		void ConsoleCore::setCommands(std::shared_ptr<CommandRegistry> commands)
+		{
+			this->commands = commands ? std::move(commands) : makeCommands();
+		}
+
+		std::shared_ptr<CommandRegistry> ConsoleCore::makeCommands()
+		{
+			auto commands = std::make_shared<CommandRegistry>();
+
+			for(auto& builtin : BUILTINS)
+				commands->add(sf::String{builtin.name}, CommandView{});
+
+			return commands;
+		}
+
+		const std::vector<Job>& ConsoleCore::getJobs() const
+		{
+			return jobs;
+		}
+
+		std::vector<ConsoleCore::TaskStats> ConsoleCore::getTaskStats() const
+		{
+			std::vector<TaskStats> stats;
+
+#ifdef DBR_CNSL_COROUTINES
+			for(auto& task : tasks)
+				stats.push_back(task.stats);
+#endif
+
+			return stats;
+		}
+
+#ifdef DBR_CNSL_STATS
+		ConsoleCore::Stats ConsoleCore::getStats() const
+		{
+			Stats stats{{commandTimes.begin(), commandTimes.end()}, drawTimes, drawVertices, charsPerSecond, editor.getMemoryUsage(), grid.getMemoryUsage()};
+
+			std::sort(stats.commands.begin(), stats.commands.end(), [](const std::pair<sf::String, Histogram>& lhs, const std::pair<sf::String, Histogram>& rhs)
+			{
+				return lhs.first < rhs.first;
+			});
+
+			return stats;
+		}
+
+		void ConsoleCore::recordDraw(sf::Time time, std::size_t vertices) const
+		{
+			drawTimes.add(time);
+			drawVertices = vertices;
+		}
+#endif
+
+		std::size_t ConsoleCore::cursorAt() const
+		{
+			return grid.getCursor();
+		}
+
+		void ConsoleCore::cursorAt(std::size_t idx)
+		{
+			grid.setCursor(idx);
+		}
+
+		const sf::Vector2u& ConsoleCore::getSize() const
+		{
+			return grid.getSize();
+		}
+
+		void ConsoleCore::setSize(sf::Vector2u size)
+		{
+			// output being written (or a command running) hides the prompt, and shows it again once done
+			auto shown = editor.isShown();
+
+			if(shown)
+				editor.hide(grid);
+
+			grid.resize(size);
+			flood.reset();
+
+			if(shown)
+				editor.show(grid);
+		}
+
+		std::size_t ConsoleCore::getScrollbackSize() const
+		{
+			return grid.getScrollbackSize();
+		}
+
+		void ConsoleCore::setScrollbackSize(std::size_t rows)
+		{
+			editor.reset();
+			grid.setScrollbackSize(rows);
+			flood.reset();
+		}
+
+		void ConsoleCore::complete()
+		{
+			auto entry = editor.getEntry();
+
+			// only the command name is completed
+			if(std::any_of(entry.begin(), entry.end(), Tokenizer::isSpace))
+				return;
+
+			if(!completions.empty())
+			{
+				completionIndex = (completionIndex + 1) % completions.size();
+				editor.replace(grid, completions[completionIndex]);
+
+				return;
+			}
+
+			auto prefix = commands->commonPrefix(entry);
+
+			if(prefix.getSize() > entry.getSize())
+			{
+				editor.replace(grid, prefix);
+			}
+			else if(commands->count(entry) > 1)
+			{
+				commands->complete(entry, completions, MAX_COMPLETIONS);
+				completionIndex = 0;
+
+				editor.replace(grid, completions[completionIndex]);
+			}
+		}
+
+		Job ConsoleCore::start(const sf::String& entry, Args&& args, const AsyncCommand& command)
+		{
+			if(!workers)
+				workers.reset(new WorkerPool{workerCount});
+
+			std::shared_ptr<Job::State> state{new Job::State{}};
+			state->entry = entry;
+			state->output = pending.get();
+			state->order = started++;
+			state->cancelled.store(false, std::memory_order_relaxed);
+			state->running.store(true, std::memory_order_relaxed);
+			state->finished = state->result.get_future().share();
+
+			Job job{std::move(state), true};
+			jobs.push_back(job);
+
+			workers->push([job, args = std::move(args), command]() mutable
+			{
+#ifdef DBR_CNSL_STATS
+				sf::Clock clock;
+#endif
+
+				try
+				{
+					// cancelled while still queued
+					if(!job.isCancelled())
+						command(args, job);
+
+#ifdef DBR_CNSL_STATS
+					job.state->time = clock.getElapsedTime();
+#endif
+					job.state->result.set_value();
+				}
+				catch(...)
+				{
+#ifdef DBR_CNSL_STATS
+					job.state->time = clock.getElapsedTime();
+#endif
+					job.state->result.set_exception(std::current_exception());
+				}
+
+				// released after the command's output was queued, so it is printed before the job is reported
+				job.state->running.store(false, std::memory_order_release);
+			});
+
+			return job;
+		}
+
+		void ConsoleCore::reapJobs()
+		{
+			auto done = std::stable_partition(jobs.begin(), jobs.end(), [](const Job& job) { return job.isRunning(); });
+
+			for(auto it = done; it != jobs.end(); ++it)
+			{
+#ifdef DBR_CNSL_STATS
+				recordCommand(nameOf(it->state->entry), it->state->time);
+#endif
+
+				try
+				{
+					it->wait();
+
+					if(it->isCancelled())
+						write(it->getEntry() + ": cancelled\n");
+				}
+				catch(const std::exception& e)
+				{
+					write(it->getEntry() + ": " + e.what() + "\n");
+				}
+				catch(...)
+				{
+					write(it->getEntry() + ": failed\n");
+				}
+			}
+
+			jobs.erase(done, jobs.end());
+		}
+
+		sf::String ConsoleCore::jobStatus() const
+		{
+			if(runningCount() == 0)
+				return{};
+
+			// the newest command's name
+			sf::String entry;
+
+#ifdef DBR_CNSL_COROUTINES
+			if(!tasks.empty() && (jobs.empty() || tasks.back().order > jobs.back().state->order))
+				entry = tasks.back().stats.entry;
+			else
+#endif
+				entry = jobs.back().getEntry();
+
+			sf::String status = "[";
+			status += nameOf(entry).toString();
+
+			if(runningCount() > 1)
+				status += " +" + std::to_string(runningCount() - 1);
+
+			status += "] ";
+
+			return status;
+		}
+
+		std::size_t ConsoleCore::runningCount() const
+		{
+#ifdef DBR_CNSL_COROUTINES
+			return jobs.size() + tasks.size();
+#else
+			return jobs.size();
+#endif
+		}
+
+		const ConsoleCore::Builtin* ConsoleCore::findBuiltin(StringView name)
+		{
+			for(auto& builtin : BUILTINS)
+			{
+				if(name == builtin.name)
+					return &builtin;
+			}
+
+			return nullptr;
+		}
+
+		void ConsoleCore::write(const sf::String& str)
+		{
+#ifdef DBR_CNSL_STATS
+			charsWritten += str.getSize();
+#endif
+
+			if(outputSink)
+				(*outputSink)(str);
+			else
+				flood.write(grid, str);
+		}
+
+		void ConsoleCore::runCVar(CVarBase& cvar, ArgsView args)
+		{
+			if(args.size() == 1)
+				write(args.front().toString() + " = " + cvar.get() + '\n');
+			else if(args.size() == 2)
+				setCVar(args.front(), cvar, args[1]);
+			else
+				write("usage: " + args.front().toString() + " [<" + cvar.getType() + ">]\n");
+		}
+
+		bool ConsoleCore::setCVar(StringView name, CVarBase& cvar, StringView value, const sf::String& where)
+		{
+			if(cvar.set(value))
+				return true;
+
+			write(where + name.toString() + ": expected " + cvar.getType() + ", got \"" + value.toString() + "\"\n");
+			return false;
+		}
+
+		CVarBase* ConsoleCore::findCVar(StringView name) const
+		{
+			auto* handler = commands->find(name);
+
+			return handler ? handler->cvar.get() : nullptr;
+		}
+
+		std::vector<sf::String> ConsoleCore::cvarNames(const sf::String& prefix) const
+		{
+			std::vector<sf::String> names;
+			commands->complete(prefix, names, commands->size());
+
+			names.erase(std::remove_if(names.begin(), names.end(), [this](const sf::String& name) { return !findCVar(name); }), names.end());
+
+			return names;
+		}
+
+		CommandRegistry& ConsoleCore::ownCommands()
+		{
+			if(commands.use_count() != 1)
+				commands = std::make_shared<CommandRegistry>(*commands);
+
+			return *commands;
+		}
+
+		void ConsoleCore::clearCommand(ArgsView)
+		{
+			// output going to a sink isn't on the grid, so a remote clear leaves the local screen alone
+			if(!outputSink)
+				clear();
+		}
+
+		void ConsoleCore::tasksCommand(ArgsView)
+		{
+			auto stats = getTaskStats();
+
+			if(stats.empty())
+			{
+				write("No tasks\n");
+				return;
+			}
+
+			auto ms = [](sf::Time time) { return time.asMicroseconds() / 1000.0; };
+
+			std::ostringstream oss;
+			oss << std::fixed << std::setprecision(2);
+
+			// per frame times, in milliseconds
+			for(auto& task : stats)
+			{
+				oss << task.entry.toAnsiString() << ": " << task.frames << " frames, last " << ms(task.last)
+					<< " max " << ms(task.max) << " avg " << ms(task.total) / task.frames << " ms\n";
+			}
+
+			write(oss.str());
+		}
+
+		void ConsoleCore::setCommand(ArgsView args)
+		{
+			if(args.size() != 3)
+			{
+				write("usage: set <name> <value>\n");
+				return;
+			}
+
+			if(auto* cvar = findCVar(args[1]))
+				setCVar(args[1], *cvar, args[2]);
+			else
+				write("set: no variable named " + args[1].toString() + '\n');
+		}
+
+		void ConsoleCore::getCommand(ArgsView args)
+		{
+			if(args.size() != 2)
+			{
+				write("usage: get <name>\n");
+				return;
+			}
+
+			if(auto* cvar = findCVar(args[1]))
+				write(args[1].toString() + " = " + cvar->get() + '\n');
+			else
+				write("get: no variable named " + args[1].toString() + '\n');
+		}
+
+		void ConsoleCore::listCommand(ArgsView args)
+		{
+			if(args.size() > 2)
+			{
+				write("usage: list [<prefix>]\n");
+				return;
+			}
+
+			auto names = cvarNames(args.size() == 2 ? args[1].toString() : sf::String{});
+
+			if(names.empty())
+			{
+				write("No variables\n");
+				return;
+			}
+
+			sf::String out;
+
+			for(auto& name : names)
+			{
+				auto* cvar = findCVar(name);
+
+				out += name + " = " + cvar->get() + " (" + cvar->getType() + ", default " + cvar->getDefault() + ')';
+
+				if(!cvar->description.isEmpty())
+					out += " " + cvar->description;
+
+				out += '\n';
+			}
+
+			write(out);
+		}
+
+		void ConsoleCore::execCommand(ArgsView args)
+		{
+			if(args.size() != 2)
+			{
+				write("usage: exec <file>\n");
+				return;
+			}
+
+			auto utf8 = args[1].toString().toUtf8();
+			std::string filename{utf8.begin(), utf8.end()};
+
+			ExecStats stats;
+
+			if(execDepth == MAX_EXEC_DEPTH)
+			{
+				write("exec: scripts are nested too deep\n");
+				return;
+			}
+
+			if(!exec(filename, stats))
+			{
+				write("exec: couldn't read " + args[1].toString() + '\n');
+				return;
+			}
+
+			auto seconds = stats.time.asSeconds();
+
+			std::ostringstream oss;
+			oss << std::fixed << std::setprecision(2) << ": " << stats.lines << " lines, " << stats.entries << " entries ("
+				<< stats.unknown << " unknown) in " << seconds * 1000.f << " ms, "
+				<< std::setprecision(0) << (seconds > 0 ? stats.lines / seconds : 0.f) << " lines/s\n";
+
+			write("exec: " + args[1].toString() + oss.str());
+		}
+
+#ifdef DBR_CNSL_STATS
+		void ConsoleCore::statsCommand(ArgsView)
+		{
+			auto stats = getStats();
+			auto ms = [](sf::Time time) { return time.asMicroseconds() / 1000.0; };
+
+			std::ostringstream oss;
+			oss << std::fixed << std::setprecision(2);
+
+			auto row = [&](const std::string& name, const Histogram& times)
+			{
+				oss << std::left << std::setw(16) << name << std::right << std::setw(8) << times.getCount()
+					<< std::setw(9) << ms(times.getMean()) << std::setw(9) << ms(times.getPercentile(0.5))
+					<< std::setw(9) << ms(times.getPercentile(0.99)) << std::setw(9) << ms(times.getMax()) << '\n';
+			};
+
+			oss << std::left << std::setw(16) << "ms" << std::right << std::setw(8) << "count"
+				<< std::setw(9) << "mean" << std::setw(9) << "p50" << std::setw(9) << "p99" << std::setw(9) << "max" << '\n';
+
+			for(auto& command : stats.commands)
+				row(command.first.toAnsiString(), command.second);
+
+			row("(draw)", stats.draw);
+
+			oss << stats.vertices << " vertices/frame, " << std::setprecision(0) << stats.charsPerSecond << " chars/s\n"
+				<< "history " << stats.historyBytes / 1024 << " KiB, scrollback " << stats.scrollbackBytes / 1024 << " KiB\n";
+
+			write(oss.str());
+		}
+
+		void ConsoleCore::recordCommand(StringView name, sf::Time time)
+		{
+#ifdef __cpp_lib_generic_unordered_lookup
+			auto it = commandTimes.find(name);
+#else
+			auto it = commandTimes.find(name.toString());
+#endif
+
+			if(it == commandTimes.end())
+				it = commandTimes.emplace(name.toString(), Histogram{}).first;
+
+			it->second.add(time);
+		}
+#endif
+
+#ifdef DBR_CNSL_COROUTINES
+		void ConsoleCore::start(const sf::String& entry, Args&& args, const FrameCommand& command)
+		{
+			Task task{std::unique_ptr<FrameCommand>{new FrameCommand{command}}, {}, {entry, 0, {}, {}, {}}, started++};
+			task.task = (*task.command)(std::move(args));
+
+			// the first run is counted as a frame, as it happens in this one
+			sf::Clock clock;
+			task.task.resume(frameSlice);
+
+			auto time = clock.getElapsedTime();
+			task.stats = {entry, 1, time, time, time};
+
+			if(task.task.isDone())
+			{
+#ifdef DBR_CNSL_STATS
+				recordCommand(nameOf(entry), time);
+#endif
+
+				reportTask(task);
+			}
+			else
+				tasks.push_back(std::move(task));
+		}
+
+		void ConsoleCore::runTasks()
+		{
+			if(tasks.empty())
+				return;
+
+			// a task that starts another makes tasks longer, so only the ones waiting now are resumed
+			auto count = tasks.size();
+			nextTask %= count;
+
+			sf::Clock frame;
+
+			for(auto i = 0u; i < count; ++i)
+			{
+				auto used = frame.getElapsedTime();
+
+				// the first one always gets a turn, so a small slice can't stall every task
+				if(i != 0 && used >= frameSlice)
+					break;
+
+				auto idx = (nextTask + i) % count;
+
+				sf::Clock clock;
+
+				if(tasks[idx].task.resume(frameSlice - used))
+				{
+					auto time = clock.getElapsedTime();
+					auto& stats = tasks[idx].stats;
+
+					++stats.frames;
+					stats.last = time;
+					stats.max = std::max(stats.max, time);
+					stats.total += time;
+				}
+			}
+
+			nextTask = (nextTask + 1) % count;
+
+			auto done = std::stable_partition(tasks.begin(), tasks.end(), [](const Task& task) { return !task.task.isDone(); });
+
+			for(auto it = done; it != tasks.end(); ++it)
+			{
+#ifdef DBR_CNSL_STATS
+				recordCommand(nameOf(it->stats.entry), it->stats.total);
+#endif
+
+				reportTask(*it);
+			}
+
+			tasks.erase(done, tasks.end());
+		}
+
+		void ConsoleCore::reportTask(const Task& task)
+		{
+			try
+			{
+				task.task.rethrow();
+			}
+			catch(const std::exception& e)
+			{
+				write(task.stats.entry + ": " + e.what() + "\n");
+			}
+			catch(...)
+			{
+				write(task.stats.entry + ": failed\n");
+			}
+		}
+#endif
+	}
+}
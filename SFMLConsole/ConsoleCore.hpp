@@ -0,0 +1,475 @@
+#ifndef DBR_CNSL_CONSOLE_CORE_HPP
+#define DBR_CNSL_CONSOLE_CORE_HPP
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include <SFML/System/String.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/System/Clock.hpp>
+
+#include "MessageQueue.hpp"
+#include "TextGrid.hpp"
+#include "LineEditor.hpp"
+#include "FloodControl.hpp"
+#include "Tokenizer.hpp"
+#include "CommandRegistry.hpp"
+#include "TypedCommand.hpp"
+#include "CVar.hpp"
+#include "StringHash.hpp"
+#include "Job.hpp"
+#include "WorkerPool.hpp"
+#include "FrameTask.hpp"
+#include "Histogram.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		using Command = std::function<void(const Args& args)>;
+		using EntryHandler = std::function<void(const sf::String&)>;
+
+		// takes output in place of the grid, while run(entry, sink) runs. Whole lines or not
+		using OutputSink = std::function<void(const sf::String& output)>;
+
+		// splits str on splitOn, skipping empty parts
+		// allocates every part. run() uses a Tokenizer instead
+		Args split(const sf::String& str, sf::Uint32 splitOn);
+
+		/*
+			Everything a console does, apart from drawing: output, the entry line, history, and commands.
+			Needs no window or GL context, so it can be driven headless (benchmarks, servers, ...)
+			Console draws one with SFML
+		*/
+		class ConsoleCore
+		{
+		public:
+			// keys that edit the entry, or move the view
+			enum class Key
+			{
+				Up,
+				Down,
+				Left,
+				Right,
+				Home,
+				End,
+				Delete,
+				PageUp,
+				PageDown,
+			};
+
+			struct QueueStats
+			{
+				std::size_t queued;		// waiting for the next update()
+				std::uint64_t posted;
+				std::uint64_t dropped;	// queue was full
+				std::uint64_t printed;
+			};
+
+			// a coroutine command waiting to be resumed by update()
+			struct TaskStats
+			{
+				sf::String entry;
+				std::size_t frames;	// it was resumed in
+				sf::Time last;		// time it ran for in the last of those frames
+				sf::Time max;
+				sf::Time total;
+			};
+
+			// what exec() ran, and how long it took
+			struct ExecStats
+			{
+				std::size_t lines;		// in the script
+				std::size_t entries;	// run. A continued entry counts once, comments and blank lines not at all
+				std::size_t unknown;	// entries no command (or the entryHandler) took
+				sf::Time time;
+			};
+
+#ifdef DBR_CNSL_STATS
+			// what the console itself costs. Only recorded with DBR_CNSL_STATS defined
+			struct Stats
+			{
+				// time to run each command, by name, in name order
+				// async commands are timed on their worker, and coroutine commands over all their frames
+				std::vector<std::pair<sf::String, Histogram>> commands;
+
+				Histogram draw;				// CPU time of a renderer's draw(). Empty without a renderer
+				std::size_t vertices;		// submitted by the last draw()
+				double charsPerSecond;		// of output, over the last second or so
+				std::size_t historyBytes;
+				std::size_t scrollbackBytes;
+			};
+#endif
+
+			/// \param size Size in characters
+			/// \param prompt Prompt string to use
+			ConsoleCore(sf::Vector2u size, const sf::String& prompt);
+
+			// a copy shares other's commands, until either adds one (see shareCommands())
+			ConsoleCore(const ConsoleCore& other);
+			ConsoleCore(ConsoleCore&& other);
+
+			// cancels running jobs, and waits for them to return
+			~ConsoleCore();
+
+			/* actions */
+
+			// typed text. Backspace and enter edit/submit the entry, tab completes the command name,
+			// Ctrl+C cancels the newest task or job. Other control characters are ignored
+			void input(sf::Uint32 unicode);
+			void input(Key key);
+
+			// call once per frame. Prints output posted from other threads and jobs, resumes coroutine commands
+			// for up to frameSlice, and reports finished jobs
+			// output's per frame budget (see getFlood()) starts over, and an incomplete last line of output is printed
+			void update();
+
+			void clear();
+
+			// moves the view by rows into the scrollback (positive is towards older output)
+			void scroll(int rows);
+
+			void addCommand(const sf::String& name, Command&& command);
+			void addCommand(const sf::String& name, CommandView&& command);
+			void addCommand(const sf::String& name, AsyncCommand&& command);
+
+			// commands with typed parameters, e.g. void(int, float, std::string_view), parsed from the arguments when run
+			// a wrong number of arguments, or one that doesn't parse, prints the command's usage instead (see TypedCommand.hpp)
+			template<typename F, std::enable_if_t<isTypedCommand<F>, int> = 0>
+			void addCommand(const sf::String& name, F&& command);
+
+#ifdef DBR_CNSL_COROUTINES
+			// commands returning a FrameTask are coroutines, spread over frames by update()
+			// a template, as such a callable would also convert to Command
+			template<typename F, typename = std::enable_if_t<std::is_invocable_r_v<FrameTask, F&, Args>>>
+			void addCommand(const sf::String& name, F&& command);
+#endif
+
+			// adds a console variable named name, replacing any command or variable named that (see CVar.hpp)
+			// running "name" prints it, and "name value" sets it, as do the set and get builtins. list lists them
+			template<typename T>
+			CVar<T> addCVar(const sf::String& name, T value, const sf::String& description = {});
+
+			// the variable named name, if it is a T. Unbound otherwise
+			template<typename T>
+			CVar<T> getCVar(const sf::String& name) const;
+
+			// writes every variable as a "name value" line, in name order. Running a line as an entry sets it back
+			bool saveCVars(const std::string& filename) const;
+
+			// sets the variables named in a file saveCVars() wrote, running their callbacks. Blank lines, and lines
+			// starting with #, are skipped. Prints the lines it couldn't set. false if the file couldn't be read
+			bool loadCVars(const std::string& filename);
+
+			// the Job is false if no command (or the entryHandler) took the entry
+			// async commands are still running on a worker when it returns
+			Job run(const sf::String& entry);
+
+			// run(), with output written while it runs (by the command, commands it runs, or the console) going to sink
+			// instead of the grid. For remote consoles. Output posted from other threads still goes to the grid.
+			// Async and coroutine commands would print after it returns, so they aren't run, and print why instead.
+			// The local prompt and entry are kept, and "clear" leaves the grid alone
+			Job run(const sf::String& entry, const OutputSink& sink);
+
+			// runs each line of a script as an entry, as run() does. Comments, entries starting with #, are skipped
+			// a line ending in a backslash is continued onto the next, as though they were one line with a space between
+			// the file is memory mapped, and decoded a batch of lines at a time, so lines aren't copied or allocated for
+			// false if the file couldn't be read, or scripts running scripts nest deeper than MAX_EXEC_DEPTH
+			bool exec(const std::string& filename, ExecStats& stats);
+
+			// cancels whichever coroutine command or running job was started last
+			// with neither running, abandons the entry being typed
+			void cancel();
+
+			// output is printed a line at a time. An incomplete line waits for the rest of it, or the next update()
+			template<typename T>
+			ConsoleCore& operator<<(const T& t);
+
+			// writes str without formatting it through a stream first
+			ConsoleCore& operator<<(const sf::String& str);
+
+			// thread safe versions of operator<<. Output is queued and printed on the next update()
+			// never blocks. Returns false if the queue is full and the output was dropped
+			bool post(sf::String str);
+
+			template<typename T>
+			bool post(const T& t);
+
+			QueueStats getQueueStats() const;
+
+			/* properties functions */
+
+			const TextGrid& getGrid() const;
+			TextGrid& getGrid();
+
+			const LineEditor& getEditor() const;
+
+			// where output enters the console: limits output per frame, and collapses repeated lines
+			FloodControl& getFlood();
+			const FloodControl& getFlood() const;
+
+			const CommandRegistry& getCommands() const;
+
+			// the registry, shared by copies of the console until one of them adds a command, which first
+			// gets a copy of its own. Copies share the commands themselves, so only the registry's index is copied
+			// commands added through the returned pointer are added for every console sharing it
+			std::shared_ptr<CommandRegistry> shareCommands() const;
+
+			// shares commands with this console, in place of its own. For many consoles with the same commands,
+			// e.g. in a registry made by makeCommands(). Builtins missing from it still run, but aren't completed
+			void setCommands(std::shared_ptr<CommandRegistry> commands);
+
+			// a new registry, with the builtins in it
+			static std::shared_ptr<CommandRegistry> makeCommands();
+
+			// async commands still running, oldest first
+			const std::vector<Job>& getJobs() const;
+
+			// coroutine commands still waiting, oldest first. Empty without C++20
+			std::vector<TaskStats> getTaskStats() const;
+
+#ifdef DBR_CNSL_STATS
+			Stats getStats() const;
+#endif
+
+			std::size_t cursorAt() const;
+			void cursorAt(std::size_t idx);
+
+			// size in characters. Output is rewrapped to the new width, and the entry shown again after it
+			// see TextGrid::resize()
+			const sf::Vector2u& getSize() const;
+			void setSize(sf::Vector2u size);
+
+			// number of rows kept for scrollback, including the visible rows. Rounded up to a multiple of the visible rows
+			// memory use is fixed at rows * columns cells (twice that once resized). Changing it clears the console
+			std::size_t getScrollbackSize() const;
+			void setScrollbackSize(std::size_t rows);
+
+			// provided if custom input handling is desired (ie: used for providing user access to a scripting language)
+			// Called when an entry does not match a provided command or builtin
+			// all input is provided as a single argument
+			EntryHandler entryHandler;
+
+			/* data */
+
+			// max posted messages printed per update()
+			std::size_t drainLimit;
+
+			// threads async commands run on. Read when the first one runs
+			std::size_t workerCount;
+
+			// time per update() shared by the coroutine commands waiting to be resumed
+			sf::Time frameSlice;
+
+		protected:
+#ifdef DBR_CNSL_STATS
+			// for renderers, once per draw()
+			void recordDraw(sf::Time time, std::size_t vertices) const;
+#endif
+
+		private:
+			static constexpr std::size_t DEFAULT_SCROLLBACK = 500u;	// in rows
+			static constexpr std::size_t DEFAULT_QUEUE_SIZE = 4096u;	// in messages
+			static constexpr std::size_t DEFAULT_DRAIN_LIMIT = 1024u;
+			static constexpr std::size_t DEFAULT_WORKER_COUNT = 2u;
+			static constexpr std::size_t MAX_COMPLETIONS = 256u;	// matches Tab cycles through
+			static constexpr sf::Int64 DEFAULT_FRAME_SLICE = 4000;	// in microseconds
+			static constexpr std::size_t EXEC_BATCH = 64u * 1024u;	// characters of a script decoded before they're run
+			static constexpr std::size_t MAX_EXEC_DEPTH = 16u;
+
+			// builtins are registered without a handler, so they are completed like other commands, and run by name
+			// they are members, rather than registered lambdas, so copies of the console don't refer back to the original
+			struct Builtin
+			{
+				const char* name;
+				void (ConsoleCore::*run)(ArgsView args);
+			};
+
+			static const Builtin BUILTINS[];
+
+			// nullptr if name isn't a builtin
+			static const Builtin* findBuiltin(StringView name);
+
+			void clearCommand(ArgsView args);
+			void tasksCommand(ArgsView args);
+			void setCommand(ArgsView args);
+			void getCommand(ArgsView args);
+			void listCommand(ArgsView args);
+			void execCommand(ArgsView args);
+#ifdef DBR_CNSL_STATS
+			void statsCommand(ArgsView args);
+
+			// adds to name's histogram
+			void recordCommand(StringView name, sf::Time time);
+#endif
+
+			// run() on a view of the entry, so exec() doesn't copy its lines into strings
+			Job dispatch(StringView entry);
+
+			// prints "name = value" with just a name, or sets it to args[1]
+			void runCVar(CVarBase& cvar, ArgsView args);
+
+			// false, printing why after where, if value doesn't parse
+			bool setCVar(StringView name, CVarBase& cvar, StringView value, const sf::String& where = {});
+
+			// nullptr if name isn't a variable
+			CVarBase* findCVar(StringView name) const;
+
+			// names of the variables starting with prefix, in order
+			std::vector<sf::String> cvarNames(const sf::String& prefix) const;
+
+			// writes output to the grid, through flood, or to the outputSink
+			void write(const sf::String& str);
+
+			// the registry, copied first if another console shares it
+			CommandRegistry& ownCommands();
+
+			// completes the command name being typed to the longest prefix its matches share
+			// Tabs after that cycle through the matches
+			void complete();
+
+			// queues command on the worker pool, starting it if needed
+			Job start(const sf::String& entry, Args&& args, const AsyncCommand& command);
+
+			// removes finished jobs, reporting any that were cancelled or threw. The prompt must be hidden
+			void reapJobs();
+
+			// what the prompt shows about running jobs and tasks
+			sf::String jobStatus() const;
+
+			// number of jobs and tasks the prompt's status counts
+			std::size_t runningCount() const;
+
+#ifdef DBR_CNSL_COROUTINES
+			struct Task
+			{
+				// the callable is kept at a fixed address, as a lambda coroutine refers to its captures through it
+				std::unique_ptr<FrameCommand> command;
+				FrameTask task;
+				TaskStats stats;
+				std::uint64_t order;	// see started
+			};
+
+			// runs command up to its first co_await, and keeps it for update() if it didn't finish
+			void start(const sf::String& entry, Args&& args, const FrameCommand& command);
+
+			// resumes waiting tasks, round robin, until frameSlice is used up. Removes finished ones
+			void runTasks();
+
+			// reports what a finished task threw
+			void reportTask(const Task& task);
+#endif
+
+			std::shared_ptr<CommandRegistry> commands;
+
+			// a command can run other entries, so each level of nesting gets its own tokenizer
+			std::vector<Tokenizer> tokenizers;
+			std::size_t runDepth;
+			std::size_t execDepth;	// scripts running scripts
+
+			// while run(entry, sink) runs. nullptr otherwise
+			const OutputSink* outputSink;
+
+			// output posted from other threads
+			std::unique_ptr<MessageQueue<sf::String>> pending;
+
+			std::vector<Job> jobs;
+
+			// jobs and coroutine commands started, numbering them so cancel() can find the newest
+			std::uint64_t started{0};
+			std::size_t shownJobs;	// runningCount() when the prompt's status was last set
+
+			// destroyed before pending, as jobs print into it
+			std::unique_ptr<WorkerPool> workers;
+
+			TextGrid grid;
+			LineEditor editor;
+			FloodControl flood;
+
+			// matches being cycled through by Tab. Emptied by any other input
+			std::vector<sf::String> completions;
+			std::size_t completionIndex;
+
+#ifdef DBR_CNSL_COROUTINES
+			std::vector<Task> tasks;
+			std::size_t nextTask{0};	// resumed first by the next update(), so every task gets a turn
+#endif
+
+#ifdef DBR_CNSL_STATS
+			std::unordered_map<sf::String, Histogram, StringHash, StringEqual> commandTimes;
+
+			mutable Histogram drawTimes;
+			mutable std::size_t drawVertices{0};
+
+			std::uint64_t charsWritten{0};
+			std::uint64_t rateStart{0};	// charsWritten when rateClock was restarted
+			sf::Clock rateClock;
+			double charsPerSecond{0};
+#endif
+		};
+
+		template<typename T>
+		CVar<T> ConsoleCore::addCVar(const sf::String& name, T value, const sf::String& description)
+		{
+			auto variable = std::make_shared<CVarValue<T>>(value, description);
+			ownCommands().add(name, std::shared_ptr<CVarBase>{variable});
+
+			return CVar<T>{std::move(variable)};
+		}
+
+		template<typename T>
+		CVar<T> ConsoleCore::getCVar(const sf::String& name) const
+		{
+			auto* handler = commands->find(name);
+
+			if(!handler || !handler->cvar)
+				return {};
+
+			return CVar<T>{std::dynamic_pointer_cast<CVarValue<T>>(handler->cvar)};
+		}
+
+		template<typename F, std::enable_if_t<isTypedCommand<F>, int>>
+		void ConsoleCore::addCommand(const sf::String& name, F&& command)
+		{
+			ownCommands().add(name, makeTypedCommand(std::forward<F>(command)));
+		}
+
+#ifdef DBR_CNSL_COROUTINES
+		template<typename F, typename>
+		void ConsoleCore::addCommand(const sf::String& name, F&& command)
+		{
+			ownCommands().add(name, FrameCommand{std::forward<F>(command)});
+		}
+#endif
+
+		template<typename T>
+		ConsoleCore& ConsoleCore::operator<<(const T& t)
+		{
+			std::ostringstream oss;
+			oss << t;
+
+			write(oss.str());
+
+			return *this;
+		}
+
+		template<typename T>
+		bool ConsoleCore::post(const T& t)
+		{
+			std::ostringstream oss;
+			oss << t;
+
+			return post(sf::String{oss.str()});
+		}
+	}
+}
+
+#endif
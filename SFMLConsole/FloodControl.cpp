@@ -0,0 +1,221 @@
+#include "FloodControl.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "TextGrid.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		FloodControl::FloodControl()
+			: charLimit{DEFAULT_CHAR_LIMIT},
+			lineLimit{DEFAULT_LINE_LIMIT},
+			coalesce{true},
+			line{},
+			continued{false},
+			last{},
+			lastValid{false},
+			lastEnd{0},
+			lastCursor{0},
+			lastFeeds{0},
+			repeats{0},
+			shownRepeats{0},
+			chars{0},
+			lines{0},
+			unreportedChars{0},
+			unreportedLines{0},
+			droppedThisFrame{false},
+			stats{0, 0, 0}
+		{}
+
+		void FloodControl::write(TextGrid& grid, StringView str)
+		{
+			auto it = str.begin();
+			const auto end = str.end();
+
+			while(it != end)
+			{
+				auto newline = std::find(it, end, static_cast<sf::Uint32>('\n'));
+
+				// an endless line is held only up to a frame's worth of characters
+				auto size = static_cast<std::size_t>(newline - it);
+				auto room = charLimit > line.size() ? charLimit - line.size() : 0;
+				auto count = std::min(size, room);
+
+				line.insert(line.end(), it, it + count);
+
+				if(count < size)
+					drop(size - count, 0);
+
+				if(newline == end)
+					break;
+
+				emit(grid, true);
+				it = newline + 1;
+			}
+		}
+
+		void FloodControl::flush(TextGrid& grid)
+		{
+			if(!line.empty())
+				emit(grid, false);
+
+			writeCount(grid);
+		}
+
+		void FloodControl::endFrame(TextGrid& grid)
+		{
+			flush(grid);
+
+			// a flood is reported once, when it is over. Not in the middle of a line
+			if(!droppedThisFrame && !continued && unreportedChars + unreportedLines != 0)
+			{
+				auto report = "(" + std::to_string(unreportedLines) + " lines, " + std::to_string(unreportedChars) + " characters dropped)\n";
+				grid.write(sf::String{report});
+
+				unreportedChars = 0;
+				unreportedLines = 0;
+				lastValid = false;
+			}
+
+			chars = 0;
+			lines = 0;
+			droppedThisFrame = false;
+		}
+
+		void FloodControl::reset()
+		{
+			lastValid = false;
+		}
+
+		bool FloodControl::hasBudget() const
+		{
+			return chars < charLimit && lines < lineLimit;
+		}
+
+		bool FloodControl::isIdle() const
+		{
+			return line.empty() && chars == 0 && lines == 0 && unreportedChars + unreportedLines == 0 && (!lastValid || repeats == shownRepeats);
+		}
+
+		const FloodControl::Stats& FloodControl::getStats() const
+		{
+			return stats;
+		}
+
+		void FloodControl::emit(TextGrid& grid, bool newline)
+		{
+			if(newline && !continued && coalesce && line == last && lastIsLive(grid))
+			{
+				++repeats;
+				++stats.repeats;
+
+				line.clear();
+				return;
+			}
+
+			auto size = line.size();
+			std::size_t count = newline ? 1 : 0;
+
+			if(chars + size > charLimit || lines + count > lineLimit)
+			{
+				drop(size, count);
+
+				lastValid = false;
+				continued = !newline;
+
+				line.clear();
+				return;
+			}
+
+			writeCount(grid);
+
+			grid.write(StringView{line.data(), size});
+			chars += size;
+
+			if(newline)
+			{
+				auto width = grid.getSize().x;
+
+				auto end = grid.getCursor();
+				auto feeds = grid.getLineFeeds();
+
+				grid.newLine();
+				lastCursor = grid.getCursor();
+				lastFeeds = grid.getLineFeeds();
+
+				// the newline scrolled the line off the top (a one row screen)
+				auto shift = static_cast<std::size_t>(lastFeeds - feeds) * width;
+
+				lastValid = coalesce && !continued && end >= shift;
+				lastEnd = end - std::min(end, shift);
+
+				// swapped, so both keep their capacity
+				last.swap(line);
+				repeats = 1;
+				shownRepeats = 1;
+
+				++lines;
+				continued = false;
+			}
+			else
+			{
+				lastValid = false;
+				continued = true;
+			}
+
+			line.clear();
+		}
+
+		bool FloodControl::lastIsLive(const TextGrid& grid) const
+		{
+			if(!lastValid)
+				return false;
+
+			auto shift = static_cast<std::size_t>(grid.getLineFeeds() - lastFeeds) * grid.getSize().x;
+
+			return lastEnd >= shift && lastCursor - shift == grid.getCursor();
+		}
+
+		void FloodControl::writeCount(TextGrid& grid)
+		{
+			if(!lastValid || repeats == shownRepeats)
+				return;
+
+			auto width = grid.getSize().x;
+			auto shift = static_cast<std::size_t>(grid.getLineFeeds() - lastFeeds) * width;
+
+			// scrolled off the screen, so it can't be changed any more
+			if(lastEnd < shift)
+			{
+				lastValid = false;
+				return;
+			}
+
+			auto count = " (x" + std::to_string(repeats) + ")";
+
+			// after the line, or over its end if there isn't room in the row
+			auto end = lastEnd - shift;
+			auto rowStart = end - end % width;
+			auto first = std::max(rowStart, std::min(end, rowStart + width - std::min<std::size_t>(width, count.size())));
+
+			for(auto i = 0u; i < count.size() && first + i < rowStart + width; ++i)
+				grid.set(first + i, static_cast<unsigned char>(count[i]));
+
+			shownRepeats = repeats;
+		}
+
+		void FloodControl::drop(std::size_t charCount, std::size_t lineCount)
+		{
+			stats.droppedChars += charCount;
+			stats.droppedLines += lineCount;
+
+			unreportedChars += charCount;
+			unreportedLines += lineCount;
+
+			droppedThisFrame = true;
+		}
+	}
+}
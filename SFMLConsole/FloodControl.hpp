@@ -0,0 +1,106 @@
+#ifndef DBR_CNSL_FLOOD_CONTROL_HPP
+#define DBR_CNSL_FLOOD_CONTROL_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <SFML/System/String.hpp>
+
+#include "StringView.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		class TextGrid;
+
+		/*
+			Where output enters a console, so a runaway logger can't cost frames.
+			Output is written a line at a time. A line identical to the one before it isn't written again,
+			the earlier one gets a " (xN)" count instead. Past a frame's budget of characters or lines,
+			output is dropped and counted, and reported once it stops.
+			Like LineEditor, the grid is passed in rather than kept
+		*/
+		class FloodControl
+		{
+		public:
+			struct Stats
+			{
+				std::uint64_t repeats;		// lines collapsed into the count of the line before them
+				std::uint64_t droppedLines;	// over a frame's budget
+				std::uint64_t droppedChars;
+			};
+
+			FloodControl();
+
+			// writes the complete lines of str. The incomplete last line is held for the rest of it, or flush()
+			void write(TextGrid& grid, StringView str);
+
+			// writes the held incomplete line, and the count of the last line if it went up
+			void flush(TextGrid& grid);
+
+			// flush(), reports what was dropped once a frame drops nothing, and starts the next frame's budget
+			void endFrame(TextGrid& grid);
+
+			// forgets the last line, so the next isn't compared with it. For when the grid was cleared
+			void reset();
+
+			// false once this frame's budget is used up
+			bool hasBudget() const;
+
+			// nothing was written since the last endFrame(), and nothing is left for it to do
+			bool isIdle() const;
+
+			const Stats& getStats() const;
+
+			// budget per frame (between endFrame()s). Repeated lines are free
+			std::size_t charLimit;
+			std::size_t lineLimit;
+
+			// collapse repeated lines
+			bool coalesce;
+
+		private:
+			static constexpr std::size_t DEFAULT_CHAR_LIMIT = 65536u;
+			static constexpr std::size_t DEFAULT_LINE_LIMIT = 1024u;
+
+			// writes line, or drops it if over budget. Repeats of the last line only add to its count
+			void emit(TextGrid& grid, bool newline);
+
+			// true if the last line's end is still on the screen, and nothing else was written after it
+			bool lastIsLive(const TextGrid& grid) const;
+
+			// writes " (xN)" after the last line, if N went up since it was last written
+			void writeCount(TextGrid& grid);
+
+			void drop(std::size_t charCount, std::size_t lineCount);
+
+			// the incomplete line, until its newline
+			std::vector<sf::Uint32> line;
+			bool continued;	// part of line was flushed already, so it can't be a repeat
+
+			// the last complete line written, and where it ended
+			std::vector<sf::Uint32> last;
+			bool lastValid;
+			std::size_t lastEnd;		// screen index of the cell after its last character
+			std::size_t lastCursor;		// screen index of the cursor after its newline
+			std::uint64_t lastFeeds;	// grid's line feeds when lastEnd/lastCursor were taken
+			std::uint64_t repeats;		// times the last line was written, including the first
+			std::uint64_t shownRepeats;
+
+			// used of this frame's budget
+			std::size_t chars;
+			std::size_t lines;
+
+			// dropped since the last report
+			std::uint64_t unreportedChars;
+			std::uint64_t unreportedLines;
+			bool droppedThisFrame;
+
+			Stats stats;
+		};
+	}
+}
+
+#endif
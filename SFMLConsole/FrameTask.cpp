@@ -0,0 +1,150 @@
+#include "FrameTask.hpp"
+
+#ifdef DBR_CNSL_COROUTINES
+
+#include <algorithm>
+#include <utility>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		FrameTask FrameTask::promise_type::get_return_object()
+		{
+			return FrameTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+		}
+
+		std::suspend_always FrameTask::promise_type::initial_suspend() noexcept
+		{
+			return{};
+		}
+
+		std::suspend_always FrameTask::promise_type::final_suspend() noexcept
+		{
+			return{};
+		}
+
+		void FrameTask::promise_type::return_void()
+		{}
+
+		void FrameTask::promise_type::unhandled_exception()
+		{
+			exception = std::current_exception();
+		}
+
+		FrameTask::FrameTask()
+			: handle{}
+		{}
+
+		FrameTask::FrameTask(std::coroutine_handle<promise_type> handle)
+			: handle{handle}
+		{}
+
+		FrameTask::FrameTask(FrameTask&& other) noexcept
+			: handle{std::exchange(other.handle, {})}
+		{}
+
+		FrameTask& FrameTask::operator=(FrameTask&& other) noexcept
+		{
+			std::swap(handle, other.handle);
+			return *this;
+		}
+
+		FrameTask::~FrameTask()
+		{
+			if(handle)
+				handle.destroy();
+		}
+
+		bool FrameTask::isDone() const
+		{
+			return !handle || handle.done();
+		}
+
+		bool FrameTask::resume(sf::Time slice)
+		{
+			if(isDone())
+				return false;
+
+			auto& promise = handle.promise();
+
+			if(promise.condition)
+			{
+				if(!promise.condition())
+					return false;
+
+				promise.condition = nullptr;
+			}
+
+			promise.slice = slice;
+			promise.resumed.restart();
+
+			handle.resume();
+
+			return true;
+		}
+
+		void FrameTask::rethrow() const
+		{
+			if(handle && handle.promise().exception)
+				std::rethrow_exception(handle.promise().exception);
+		}
+
+		bool NextFrame::await_ready() const noexcept
+		{
+			return false;
+		}
+
+		void NextFrame::await_suspend(std::coroutine_handle<>) const noexcept
+		{}
+
+		void NextFrame::await_resume() const noexcept
+		{}
+
+		bool Budget::await_ready() const noexcept
+		{
+			return false;
+		}
+
+		bool Budget::await_suspend(std::coroutine_handle<FrameTask::promise_type> handle) const noexcept
+		{
+			auto& promise = handle.promise();
+
+			// returning false carries on without suspending
+			return promise.resumed.getElapsedTime() >= std::min(time, promise.slice);
+		}
+
+		void Budget::await_resume() const noexcept
+		{}
+
+		bool Until::await_ready()
+		{
+			return predicate();
+		}
+
+		void Until::await_suspend(std::coroutine_handle<FrameTask::promise_type> handle)
+		{
+			handle.promise().condition = std::move(predicate);
+		}
+
+		void Until::await_resume() const noexcept
+		{}
+
+		NextFrame nextFrame()
+		{
+			return{};
+		}
+
+		Budget budget(sf::Time time)
+		{
+			return{time};
+		}
+
+		Until until(std::function<bool()> predicate)
+		{
+			return{std::move(predicate)};
+		}
+	}
+}
+
+#endif
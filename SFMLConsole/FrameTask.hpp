@@ -0,0 +1,115 @@
+#ifndef DBR_CNSL_FRAME_TASK_HPP
+#define DBR_CNSL_FRAME_TASK_HPP
+
+// coroutine commands need C++20, and are built with SFMLCONSOLE_COROUTINES, which defines DBR_CNSL_COROUTINES for the
+// library and everything using it, so they all agree on the console's layout. Without it, none of this is declared,
+// and the rest of the console works as before
+#if defined(DBR_CNSL_COROUTINES) && !defined(__cpp_impl_coroutine)
+#	error "DBR_CNSL_COROUTINES needs C++20 coroutines"
+#endif
+
+#ifdef DBR_CNSL_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Time.hpp>
+
+#include "Tokenizer.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			Return type of commands that spread their work over frames, as C++20 coroutines.
+			The console runs the command up to its first co_await, then resumes it from update(),
+			sharing ConsoleCore::frameSlice between all waiting commands. A command can co_await:
+				nextFrame()			resumes on the next update()
+				budget(time)		carries on if it has run for less than time since it was last resumed, and the frame's
+									slice isn't used up. Otherwise resumes on the next update()
+				until(predicate)	resumes on the first update() that predicate() returns true in
+		*/
+		class FrameTask
+		{
+		public:
+			struct promise_type
+			{
+				FrameTask get_return_object();
+
+				// started by resume(), so the console has stored the task first
+				std::suspend_always initial_suspend() noexcept;
+
+				// kept until the console has seen it finish
+				std::suspend_always final_suspend() noexcept;
+
+				void return_void();
+				void unhandled_exception();
+
+				std::function<bool()> condition;	// from until(). Checked before resuming
+				sf::Clock resumed;
+				sf::Time slice;	// left in the frame when last resumed
+				std::exception_ptr exception;
+			};
+
+			FrameTask();
+			FrameTask(FrameTask&& other) noexcept;
+			FrameTask& operator=(FrameTask&& other) noexcept;
+
+			// destroying an unfinished task cancels it, at the co_await it is suspended at
+			~FrameTask();
+
+			bool isDone() const;
+
+			// runs the command until its next co_await, with slice left in this frame
+			// returns false without running it if it is waiting on until() and the predicate is still false
+			bool resume(sf::Time slice);
+
+			// rethrows what the command threw, if anything
+			void rethrow() const;
+
+		private:
+			explicit FrameTask(std::coroutine_handle<promise_type> handle);
+
+			std::coroutine_handle<promise_type> handle;
+		};
+
+		// takes its arguments by value, as they are needed after the entry is gone
+		using FrameCommand = std::function<FrameTask(Args args)>;
+
+		struct NextFrame
+		{
+			bool await_ready() const noexcept;
+			void await_suspend(std::coroutine_handle<>) const noexcept;
+			void await_resume() const noexcept;
+		};
+
+		struct Budget
+		{
+			sf::Time time;
+
+			bool await_ready() const noexcept;
+			bool await_suspend(std::coroutine_handle<FrameTask::promise_type> handle) const noexcept;
+			void await_resume() const noexcept;
+		};
+
+		struct Until
+		{
+			std::function<bool()> predicate;
+
+			bool await_ready();
+			void await_suspend(std::coroutine_handle<FrameTask::promise_type> handle);
+			void await_resume() const noexcept;
+		};
+
+		NextFrame nextFrame();
+		Budget budget(sf::Time time);
+		Until until(std::function<bool()> predicate);
+	}
+}
+
+#endif
+
+#endif
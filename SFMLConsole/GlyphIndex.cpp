@@ -0,0 +1,159 @@
+#include "GlyphIndex.hpp"
+
+namespace dbr
+{
+	namespace sfml
+	{
+		GlyphIndex::GlyphIndex()
+			: dense(DENSE_SIZE, Entry{EMPTY, {}}),
+			sparse{},
+			denseCount{0},
+			sparseCount{0},
+			sparseShift{32}
+		{}
+
+		void GlyphIndex::clear()
+		{
+			dense.assign(DENSE_SIZE, Entry{EMPTY, {}});
+			sparse.clear();
+			denseCount = 0;
+			sparseCount = 0;
+			sparseShift = 32;
+		}
+
+		void GlyphIndex::insert(sf::Uint32 codePoint, sf::Vector2u coord, sf::Uint32 cell)
+		{
+			if(codePoint < DENSE_SIZE)
+			{
+				if(dense[codePoint].codePoint == EMPTY)
+					++denseCount;
+
+				dense[codePoint] = {codePoint, {coord, cell}};
+				return;
+			}
+
+			// keep the load factor at or below 1/2, so probe sequences stay short
+			if((sparseCount + 1) * 2 > sparse.size())
+				growSparse();
+
+			auto mask = sparse.size() - 1;
+
+			for(auto slot = slotOf(codePoint); ; slot = (slot + 1) & mask)
+			{
+				auto& entry = sparse[slot];
+
+				if(entry.codePoint == EMPTY)
+				{
+					entry = {codePoint, {coord, cell}};
+					++sparseCount;
+					return;
+				}
+				else if(entry.codePoint == codePoint)
+				{
+					entry.glyph = {coord, cell};
+					return;
+				}
+			}
+		}
+
+		void GlyphIndex::erase(sf::Uint32 codePoint)
+		{
+			if(codePoint < DENSE_SIZE)
+			{
+				if(dense[codePoint].codePoint != EMPTY)
+				{
+					dense[codePoint].codePoint = EMPTY;
+					--denseCount;
+				}
+
+				return;
+			}
+
+			if(sparseCount == 0)
+				return;
+
+			auto mask = sparse.size() - 1;
+			auto hole = slotOf(codePoint);
+
+			for(; sparse[hole].codePoint != codePoint; hole = (hole + 1) & mask)
+			{
+				if(sparse[hole].codePoint == EMPTY)
+					return;
+			}
+
+			// shift the rest of the probe run back over the hole, so no lookup stops early at it.
+			// An entry can move into the hole if the hole is between its home slot and where it is now
+			for(auto next = (hole + 1) & mask; sparse[next].codePoint != EMPTY; next = (next + 1) & mask)
+			{
+				auto home = slotOf(sparse[next].codePoint);
+
+				if(((next - home) & mask) >= ((next - hole) & mask))
+				{
+					sparse[hole] = sparse[next];
+					hole = next;
+				}
+			}
+
+			sparse[hole].codePoint = EMPTY;
+			--sparseCount;
+		}
+
+		const GlyphIndex::Glyph* GlyphIndex::find(sf::Uint32 codePoint) const
+		{
+			if(codePoint < DENSE_SIZE)
+			{
+				auto& entry = dense[codePoint];
+				return entry.codePoint != EMPTY ? &entry.glyph : nullptr;
+			}
+
+			if(sparseCount == 0)
+				return nullptr;
+
+			auto mask = sparse.size() - 1;
+
+			for(auto slot = slotOf(codePoint); ; slot = (slot + 1) & mask)
+			{
+				auto& entry = sparse[slot];
+
+				if(entry.codePoint == codePoint)
+					return &entry.glyph;
+				else if(entry.codePoint == EMPTY)
+					return nullptr;
+			}
+		}
+
+		std::size_t GlyphIndex::size() const
+		{
+			return denseCount + sparseCount;
+		}
+
+		std::size_t GlyphIndex::slotOf(sf::Uint32 codePoint) const
+		{
+			// Fibonacci hashing: the high bits of the product are well mixed, even for runs of codepoints
+			return static_cast<sf::Uint32>(codePoint * 2654435769u) >> sparseShift;
+		}
+
+		void GlyphIndex::growSparse()
+		{
+			std::vector<Entry> old{std::move(sparse)};
+
+			auto size = old.empty() ? 64u : old.size() * 2;
+
+			sparse.assign(size, Entry{EMPTY, {}});
+			sparseCount = 0;
+
+			sparseShift = 32;
+			while(size > 1)
+			{
+				size >>= 1;
+				--sparseShift;
+			}
+
+			for(auto& entry : old)
+			{
+				if(entry.codePoint != EMPTY)
+					insert(entry.codePoint, entry.glyph.coord, entry.glyph.cell);
+			}
+		}
+	}
+}
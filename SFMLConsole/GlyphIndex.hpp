@@ -0,0 +1,87 @@
+#ifndef DBR_SFML_GLYPH_INDEX_HPP
+#define DBR_SFML_GLYPH_INDEX_HPP
+
+#include <vector>
+
+#include <SFML/Config.hpp>
+#include <SFML/System/Vector2.hpp>
+
+namespace dbr
+{
+	namespace sfml
+	{
+		/*
+			Maps codepoints to the top-left texture coordinate of their glyph.
+			Codepoints below DENSE_SIZE (Basic Latin through Latin Extended-B) are a direct array index.
+			All others go through an open addressing hash table with linear probing,
+			so a lookup is one or two probes into contiguous memory
+		*/
+		class GlyphIndex
+		{
+		public:
+			struct Glyph
+			{
+				sf::Vector2u coord;
+				sf::Uint32 cell;	// for caches, which atlas cell coord is in, without dividing it by the cell size
+			};
+
+			static constexpr sf::Uint32 DENSE_SIZE = 0x250u;
+
+			GlyphIndex();
+
+			void clear();
+
+			// replaces any existing entry for codePoint
+			void insert(sf::Uint32 codePoint, sf::Vector2u coord, sf::Uint32 cell = 0);
+
+			// does nothing if codePoint has no glyph
+			void erase(sf::Uint32 codePoint);
+
+			// returns nullptr if codePoint has no glyph
+			const Glyph* find(sf::Uint32 codePoint) const;
+
+			std::size_t size() const;
+
+			// calls f(codePoint, glyph) for every glyph, in no particular order
+			template<typename F>
+			void forEach(F&& f) const;
+
+		private:
+			struct Entry
+			{
+				sf::Uint32 codePoint;
+				Glyph glyph;
+			};
+
+			static constexpr sf::Uint32 EMPTY = 0xffffffffu;
+
+			std::size_t slotOf(sf::Uint32 codePoint) const;
+			void growSparse();
+
+			std::vector<Entry> dense;
+			std::vector<Entry> sparse;
+
+			std::size_t denseCount;
+			std::size_t sparseCount;
+			unsigned int sparseShift;
+		};
+
+		template<typename F>
+		void GlyphIndex::forEach(F&& f) const
+		{
+			for(auto& entry : dense)
+			{
+				if(entry.codePoint != EMPTY)
+					f(entry.codePoint, entry.glyph);
+			}
+
+			for(auto& entry : sparse)
+			{
+				if(entry.codePoint != EMPTY)
+					f(entry.codePoint, entry.glyph);
+			}
+		}
+	}
+}
+
+#endif
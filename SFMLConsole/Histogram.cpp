@@ -0,0 +1,73 @@
+#include "Histogram.hpp"
+
+#include <algorithm>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		Histogram::Histogram()
+			: buckets{},
+			count{0},
+			total{0},
+			max{0}
+		{}
+
+		void Histogram::add(sf::Time time)
+		{
+			auto us = std::max<sf::Int64>(time.asMicroseconds(), 0);
+
+			// number of bits needed for us
+			std::size_t idx = 0;
+			while(idx < BUCKETS - 1 && (us >> idx) != 0)
+				++idx;
+
+			++buckets[idx];
+			++count;
+			total += us;
+			max = std::max(max, us);
+		}
+
+		std::uint64_t Histogram::getCount() const
+		{
+			return count;
+		}
+
+		sf::Time Histogram::getTotal() const
+		{
+			return sf::microseconds(total);
+		}
+
+		sf::Time Histogram::getMean() const
+		{
+			return sf::microseconds(count != 0 ? total / static_cast<sf::Int64>(count) : 0);
+		}
+
+		sf::Time Histogram::getMax() const
+		{
+			return sf::microseconds(max);
+		}
+
+		sf::Time Histogram::getPercentile(double q) const
+		{
+			auto target = static_cast<std::uint64_t>(q * count + 0.5);
+			std::uint64_t seen = 0;
+
+			for(auto i = 0u; i < BUCKETS; ++i)
+			{
+				seen += buckets[i];
+
+				// the bucket's bound can be past anything actually added
+				if(seen >= target && seen != 0)
+					return sf::microseconds(std::min(sf::Int64{1} << i, max));
+			}
+
+			return sf::microseconds(max);
+		}
+
+		std::uint64_t Histogram::getBucket(std::size_t idx) const
+		{
+			return buckets[idx];
+		}
+	}
+}
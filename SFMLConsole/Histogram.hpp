@@ -0,0 +1,48 @@
+#ifndef DBR_CNSL_HISTOGRAM_HPP
+#define DBR_CNSL_HISTOGRAM_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+#include <SFML/System/Time.hpp>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			Counts durations in power of 2 microsecond buckets, so adding one is a few instructions
+			and the histogram is a fixed, small size, however many are added.
+			Percentiles are only exact to within a factor of 2
+		*/
+		class Histogram
+		{
+		public:
+			// bucket i holds durations under 2^i microseconds, and at least 2^(i-1). The last also holds anything longer
+			static constexpr std::size_t BUCKETS = 32u;
+
+			Histogram();
+
+			void add(sf::Time time);
+
+			std::uint64_t getCount() const;
+			sf::Time getTotal() const;
+			sf::Time getMean() const;
+			sf::Time getMax() const;
+
+			// upper bound of the bucket holding the q-th (0 to 1) fraction of durations
+			sf::Time getPercentile(double q) const;
+
+			std::uint64_t getBucket(std::size_t idx) const;
+
+		private:
+			std::array<std::uint64_t, BUCKETS> buckets;
+			std::uint64_t count;
+			sf::Int64 total;	// in microseconds
+			sf::Int64 max;
+		};
+	}
+}
+
+#endif
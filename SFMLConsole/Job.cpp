@@ -0,0 +1,69 @@
+#include "Job.hpp"
+
+#include <thread>
+#include <utility>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		Job::Job()
+			: state{},
+			ran{false}
+		{}
+
+		Job::Job(std::shared_ptr<State> state, bool ran)
+			: state{std::move(state)},
+			ran{ran}
+		{}
+
+		Job::operator bool() const
+		{
+			return ran;
+		}
+
+		bool Job::isRunning() const
+		{
+			return state && state->running.load(std::memory_order_acquire);
+		}
+
+		void Job::cancel()
+		{
+			if(state)
+				state->cancelled.store(true, std::memory_order_relaxed);
+		}
+
+		bool Job::isCancelled() const
+		{
+			return state && state->cancelled.load(std::memory_order_relaxed);
+		}
+
+		void Job::wait() const
+		{
+			if(state)
+				state->finished.get();
+		}
+
+		sf::String Job::getEntry() const
+		{
+			return state ? state->entry : sf::String{};
+		}
+
+		bool Job::post(sf::String str)
+		{
+			if(!state)
+				return false;
+
+			// the render thread drains the queue every frame, so room is never far off
+			while(!state->output->tryPush(std::move(str)))
+			{
+				if(isCancelled())
+					return false;
+
+				std::this_thread::yield();
+			}
+
+			return true;
+		}
+	}
+}
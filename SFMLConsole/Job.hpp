@@ -0,0 +1,91 @@
+#ifndef DBR_CNSL_JOB_HPP
+#define DBR_CNSL_JOB_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <sstream>
+
+#include <SFML/System/String.hpp>
+#include <SFML/System/Time.hpp>
+
+#include "MessageQueue.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			Handle to an entry run by ConsoleCore::run(). Copies share the same job.
+			Async commands run on a worker thread, and are given their Job to print output and check for cancellation.
+			Other commands have already returned by the time run() does, so their Job is never running.
+			A default constructed Job ran nothing
+		*/
+		class Job
+		{
+		public:
+			Job();
+
+			// false if no command or entry handler took the entry
+			explicit operator bool() const;
+
+			bool isRunning() const;
+
+			// asks the command to stop. It's up to the command to check isCancelled() and return early
+			void cancel();
+			bool isCancelled() const;
+
+			// blocks until the command returns. Rethrows anything the command threw
+			void wait() const;
+
+			// empty if the job didn't run on a worker
+			sf::String getEntry() const;
+
+			// for the command: prints str on the console's next update(). Thread safe
+			// if the console's output queue is full, waits for room rather than dropping str, unless the job is cancelled
+			// returns false if str was dropped
+			bool post(sf::String str);
+
+			template<typename T>
+			bool post(const T& t);
+
+		private:
+			friend class ConsoleCore;
+
+			struct State
+			{
+				sf::String entry;
+				MessageQueue<sf::String>* output;
+
+				std::uint64_t order;	// among the jobs and coroutine commands its console started
+
+				std::atomic<bool> cancelled;
+				std::atomic<bool> running;
+
+				std::promise<void> result;
+				std::shared_future<void> finished;
+
+#ifdef DBR_CNSL_STATS
+				sf::Time time;	// the command ran for
+#endif
+			};
+
+			Job(std::shared_ptr<State> state, bool ran);
+
+			std::shared_ptr<State> state;
+			bool ran;
+		};
+
+		template<typename T>
+		bool Job::post(const T& t)
+		{
+			std::ostringstream oss;
+			oss << t;
+
+			return post(sf::String{oss.str()});
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,308 @@
+#include "LineEditor.hpp"
+
+#include <algorithm>
+
+#include "TextGrid.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		LineEditor::LineEditor(const sf::String& prompt)
+			: prompt{prompt},
+			status{},
+			text{},
+			gapStart{0},
+			gapEnd{0},
+			index{0},
+			origin{0},
+			promptStart{0},
+			shown{false},
+			history{},
+			historyIndex{0}
+		{}
+
+		void LineEditor::begin(TextGrid& grid)
+		{
+			promptStart = grid.getCursor();
+			grid.write(status);
+			grid.write(prompt);
+
+			reset();
+			origin = grid.getCursor();
+			shown = true;
+		}
+
+		void LineEditor::hide(TextGrid& grid)
+		{
+			grid.setCursor(promptStart);
+			grid.erase(origin - promptStart + getSize());
+			shown = false;
+		}
+
+		void LineEditor::show(TextGrid& grid)
+		{
+			// output that didn't end its line keeps the rest of it. With nothing written since hide(), the prompt goes
+			// back where it was, even mid row
+			if(grid.getCursor() != promptStart && grid.getCursor() % grid.getSize().x != 0)
+				grid.newLine();
+
+			promptStart = grid.getCursor();
+			grid.write(status);
+			grid.write(prompt);
+			origin = grid.getCursor();
+
+			// the entry no longer fitting behind a longer status drops its end
+			auto size = getSize();
+
+			while(size != 0 && !fit(grid, size))
+				--size;
+
+			if(size != getSize())
+			{
+				moveGap(size, 0);
+				gapEnd = text.size();
+				index = std::min(index, size);
+			}
+
+			for(auto idx = 0u; idx < size; ++idx)
+				grid.set(origin + idx, at(idx));
+
+			setIndex(grid, index);
+			shown = true;
+		}
+
+		sf::String LineEditor::submit(TextGrid& grid)
+		{
+			auto entry = getEntry();
+
+			// written over itself, so the grid knows where the entry wrapped, and leaves it wrapped there
+			grid.setCursor(origin);
+			grid.write(entry);
+
+			// an entry ending on the last cell of a row already left the cursor on the next line
+			if(grid.getCursor() % grid.getSize().x != 0 || getSize() + prompt.getSize() == 0)
+				grid.newLine();
+
+			history.push_back(entry);
+			historyIndex = history.size();
+
+			reset();
+			shown = false;
+
+			return entry;
+		}
+
+		void LineEditor::insert(TextGrid& grid, sf::Uint32 unicode)
+		{
+			auto oldSize = getSize();
+
+			if(!fit(grid, oldSize + 1))
+				return;
+
+			moveGap(index, 1);
+			text[gapStart++] = unicode;
+
+			// everything after the cursor moves right by one
+			repaint(grid, index, oldSize, [&](std::size_t idx)
+			{
+				return at(idx + 1);
+			});
+
+			setIndex(grid, index + 1);
+		}
+
+		void LineEditor::erase(TextGrid& grid, std::size_t idx)
+		{
+			auto oldSize = getSize();
+
+			if(idx >= oldSize)
+				return;
+
+			moveGap(idx, 0);
+			auto removed = text[gapEnd++];
+
+			// everything after idx moves left by one
+			repaint(grid, idx, oldSize, [&](std::size_t i)
+			{
+				return i == idx ? removed : at(i - 1);
+			});
+
+			setIndex(grid, idx);
+		}
+
+		std::size_t LineEditor::getIndex() const
+		{
+			return index;
+		}
+
+		void LineEditor::setIndex(TextGrid& grid, std::size_t idx)
+		{
+			if(idx <= getSize())
+			{
+				index = idx;
+				grid.setCursor(origin + index);
+			}
+		}
+
+		void LineEditor::historyPrev(TextGrid& grid)
+		{
+			if(historyIndex > 0)
+				--historyIndex;
+
+			replace(grid, historyIndex < history.size() ? history[historyIndex] : "");
+		}
+
+		void LineEditor::historyNext(TextGrid& grid)
+		{
+			if(historyIndex < history.size())
+				++historyIndex;
+
+			replace(grid, historyIndex < history.size() ? history[historyIndex] : "");
+		}
+
+		void LineEditor::replace(TextGrid& grid, const sf::String& entry)
+		{
+			if(!fit(grid, entry.getSize()))
+				return;
+
+			auto oldSize = getSize();
+			auto old = std::move(text);
+			auto oldGapStart = gapStart;
+			auto oldGapEnd = gapEnd;
+
+			text.assign(entry.begin(), entry.end());
+			text.resize(text.size() + MIN_GAP);
+			gapStart = entry.getSize();
+			gapEnd = text.size();
+
+			repaint(grid, 0, oldSize, [&](std::size_t idx)
+			{
+				return idx < oldGapStart ? old[idx] : old[idx + oldGapEnd - oldGapStart];
+			});
+
+			setIndex(grid, gapStart);
+		}
+
+		void LineEditor::reset()
+		{
+			gapStart = 0;
+			gapEnd = text.size();
+			index = 0;
+		}
+
+		bool LineEditor::isShown() const
+		{
+			return shown;
+		}
+
+		sf::String LineEditor::getEntry() const
+		{
+			auto entry = sf::String::fromUtf32(text.begin(), text.begin() + gapStart);
+			entry += sf::String::fromUtf32(text.begin() + gapEnd, text.end());
+
+			return entry;
+		}
+
+		std::size_t LineEditor::getSize() const
+		{
+			return text.size() - (gapEnd - gapStart);
+		}
+
+		const sf::String& LineEditor::getPrompt() const
+		{
+			return prompt;
+		}
+
+		const sf::String& LineEditor::getStatus() const
+		{
+			return status;
+		}
+
+		void LineEditor::setStatus(const sf::String& status)
+		{
+			this->status = status;
+		}
+
+		const std::vector<sf::String>& LineEditor::getHistory() const
+		{
+			return history;
+		}
+
+		std::size_t LineEditor::getMemoryUsage() const
+		{
+			auto bytes = text.capacity() * sizeof(sf::Uint32) + history.capacity() * sizeof(sf::String);
+
+			for(auto& entry : history)
+				bytes += entry.getSize() * sizeof(sf::Uint32);
+
+			return bytes;
+		}
+
+		sf::Uint32 LineEditor::at(std::size_t idx) const
+		{
+			return idx < gapStart ? text[idx] : text[idx + gapEnd - gapStart];
+		}
+
+		void LineEditor::moveGap(std::size_t idx, std::size_t count)
+		{
+			if(idx < gapStart)
+			{
+				gapEnd = std::copy_backward(text.begin() + idx, text.begin() + gapStart, text.begin() + gapEnd) - text.begin();
+				gapStart = idx;
+			}
+			else if(idx > gapStart)
+			{
+				std::copy(text.begin() + gapEnd, text.begin() + gapEnd + (idx - gapStart), text.begin() + gapStart);
+				gapEnd += idx - gapStart;
+				gapStart = idx;
+			}
+
+			if(gapEnd - gapStart < count)
+			{
+				// grow geometrically, so a long entry is moved a logarithmic number of times
+				auto grow = text.size() > MIN_GAP ? text.size() : MIN_GAP;
+				text.insert(text.begin() + gapEnd, grow, 0);
+				gapEnd += grow;
+			}
+		}
+
+		bool LineEditor::fit(TextGrid& grid, std::size_t length)
+		{
+			auto width = grid.getSize().x;
+
+			// at best, the prompt starts on the top row
+			if(promptStart % width + origin - promptStart + length >= width * grid.getSize().y)
+				return false;
+
+			auto end = origin + length;
+			auto cursor = grid.getCursor();
+
+			// setCursor() scrolls the grid up until end is on screen
+			grid.setCursor(end);
+			auto scrolled = end - grid.getCursor();
+
+			origin -= scrolled;
+			promptStart -= scrolled;
+			grid.setCursor(cursor - scrolled);
+
+			return true;
+		}
+
+		template<typename Previous>
+		void LineEditor::repaint(TextGrid& grid, std::size_t first, std::size_t oldSize, Previous previous)
+		{
+			auto size = getSize();
+			auto last = std::max(size, oldSize);
+
+			for(auto idx = first; idx < last; ++idx)
+			{
+				auto now = idx < size ? at(idx) : TextGrid::EMPTY_CELL;
+				auto before = idx < oldSize ? previous(idx) : TextGrid::EMPTY_CELL;
+
+				if(now != before)
+					grid.set(origin + idx, now);
+			}
+		}
+	}
+}
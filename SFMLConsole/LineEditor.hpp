@@ -0,0 +1,118 @@
+#ifndef DBR_CNSL_LINE_EDITOR_HPP
+#define DBR_CNSL_LINE_EDITOR_HPP
+
+#include <vector>
+#include <cstddef>
+
+#include <SFML/System/String.hpp>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		class TextGrid;
+
+		/*
+			The entry being typed after the prompt, and the history of submitted entries.
+			Edits are echoed into a TextGrid, starting at the cell after the prompt. Long entries wrap onto the following rows.
+			The grid is passed in rather than kept, so the editor can be copied along with its owner.
+
+			The entry is a gap buffer: the unused capacity sits at the last edit, so typing or deleting there
+			doesn't move the rest of the entry. Edits only rewrite the cells whose character changed
+		*/
+		class LineEditor
+		{
+		public:
+			explicit LineEditor(const sf::String& prompt);
+
+			// writes the status and prompt at the grid's cursor, and starts a new, empty entry
+			void begin(TextGrid& grid);
+
+			// empties the prompt and entry's cells, leaving the cursor where the prompt started,
+			// so output can be written in their place
+			void hide(TextGrid& grid);
+
+			// after hide(), writes the status, prompt and entry again on the line after the cursor
+			// or where they were, if nothing was written since
+			void show(TextGrid& grid);
+
+			// moves the cursor past the entry, saves it in the history, and returns it
+			// the entry stays in the grid as output, with no prompt shown until the next begin()
+			sf::String submit(TextGrid& grid);
+
+			// the prompt is in the grid: after begin() or show(), until hide() or submit()
+			bool isShown() const;
+
+			// inserts at the cursor, and moves the cursor past it
+			// ignored if the entry would no longer fit on the screen
+			void insert(TextGrid& grid, sf::Uint32 unicode);
+
+			// removes the character at idx in the entry
+			void erase(TextGrid& grid, std::size_t idx);
+
+			// position of the cursor in the entry
+			std::size_t getIndex() const;
+			void setIndex(TextGrid& grid, std::size_t idx);
+
+			// replaces the entry with an older/newer one from the history
+			void historyPrev(TextGrid& grid);
+			void historyNext(TextGrid& grid);
+
+			// replaces the whole entry, leaving the cursor at its end
+			void replace(TextGrid& grid, const sf::String& entry);
+
+			// forgets the entry, without touching the grid
+			void reset();
+
+			sf::String getEntry() const;
+
+			// characters in the entry
+			std::size_t getSize() const;
+
+			const sf::String& getPrompt() const;
+
+			// shown before the prompt, from the next begin()/show()
+			const sf::String& getStatus() const;
+			void setStatus(const sf::String& status);
+			const std::vector<sf::String>& getHistory() const;
+
+			// bytes held by the history and the entry's buffer (estimated, as sf::String doesn't expose its capacity)
+			std::size_t getMemoryUsage() const;
+
+		private:
+			static constexpr std::size_t MIN_GAP = 64u;
+
+			sf::Uint32 at(std::size_t idx) const;
+
+			// moves the gap to idx in the entry, making it at least count long
+			void moveGap(std::size_t idx, std::size_t count);
+
+			// scrolls the grid if the entry, once length long, would end past the bottom of the screen
+			// false if it can't fit on the screen at all
+			bool fit(TextGrid& grid, std::size_t length);
+
+			// rewrites the cells of the entry from first, to show the entry as it is now. Cells that didn't change are skipped
+			// previous(idx) is what cell idx showed before. The entry used to be oldSize long
+			template<typename Previous>
+			void repaint(TextGrid& grid, std::size_t first, std::size_t oldSize, Previous previous);
+
+			sf::String prompt;
+			sf::String status;
+
+			// entry characters are text[0, gapStart) followed by text[gapEnd, text.size())
+			std::vector<sf::Uint32> text;
+			std::size_t gapStart;
+			std::size_t gapEnd;
+
+			std::size_t index;	// of the cursor, in the entry
+			std::size_t origin;	// screen index of the entry's first cell
+			std::size_t promptStart;	// screen index of the status/prompt's first cell
+			bool shown;
+
+			std::vector<sf::String> history;
+			std::size_t historyIndex;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,176 @@
+#include "MappedFile.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		MappedFile::MappedFile()
+			: first{nullptr},
+			count{0},
+			opened{false}
+#ifdef _WIN32
+			, file{INVALID_HANDLE_VALUE},
+			mapping{nullptr}
+#endif
+		{}
+
+		MappedFile::~MappedFile()
+		{
+			close();
+		}
+
+		MappedFile::MappedFile(MappedFile&& other)
+			: MappedFile{}
+		{
+			*this = std::move(other);
+		}
+
+		MappedFile& MappedFile::operator=(MappedFile&& other)
+		{
+			if(this != &other)
+			{
+				close();
+
+				std::swap(first, other.first);
+				std::swap(count, other.count);
+				std::swap(opened, other.opened);
+
+#ifdef _WIN32
+				std::swap(file, other.file);
+				std::swap(mapping, other.mapping);
+#endif
+			}
+
+			return *this;
+		}
+
+		bool MappedFile::open(const std::string& filename)
+		{
+			close();
+
+#ifdef _WIN32
+			file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+			if(file == INVALID_HANDLE_VALUE)
+				return false;
+
+			LARGE_INTEGER fileSize;
+
+			if(!GetFileSizeEx(file, &fileSize))
+			{
+				close();
+				return false;
+			}
+
+			count = static_cast<std::size_t>(fileSize.QuadPart);
+
+			// a zero length file can't be mapped
+			if(count != 0)
+			{
+				mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+				if(mapping)
+					first = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+				if(!first)
+				{
+					close();
+					return false;
+				}
+			}
+#else
+			int fd = ::open(filename.c_str(), O_RDONLY);
+
+			if(fd < 0)
+				return false;
+
+			struct stat info;
+
+			if(fstat(fd, &info) != 0)
+			{
+				::close(fd);
+				return false;
+			}
+
+			count = static_cast<std::size_t>(info.st_size);
+
+			// a zero length file can't be mapped
+			if(count != 0)
+			{
+				auto* mapped = mmap(nullptr, count, PROT_READ, MAP_PRIVATE, fd, 0);
+
+				if(mapped == MAP_FAILED)
+				{
+					::close(fd);
+					count = 0;
+					return false;
+				}
+
+				first = static_cast<const char*>(mapped);
+			}
+
+			// the mapping keeps the file open
+			::close(fd);
+#endif
+
+			opened = true;
+			return true;
+		}
+
+		void MappedFile::close()
+		{
+#ifdef _WIN32
+			if(first)
+				UnmapViewOfFile(first);
+
+			if(mapping)
+				CloseHandle(mapping);
+
+			if(file != INVALID_HANDLE_VALUE)
+				CloseHandle(file);
+
+			mapping = nullptr;
+			file = INVALID_HANDLE_VALUE;
+#else
+			if(first)
+				munmap(const_cast<char*>(first), count);
+#endif
+
+			first = nullptr;
+			count = 0;
+			opened = false;
+		}
+
+		bool MappedFile::isOpen() const
+		{
+			return opened;
+		}
+
+		const char* MappedFile::data() const
+		{
+			return first;
+		}
+
+		std::size_t MappedFile::size() const
+		{
+			return count;
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#ifndef DBR_CNSL_MAPPED_FILE_HPP
+#define DBR_CNSL_MAPPED_FILE_HPP
+
+#include <string>
+#include <cstddef>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			A whole file, mapped read only into memory, so it can be read in place without copying it.
+			The OS pages it in as it is read. Unmapped when closed or destroyed
+		*/
+		class MappedFile
+		{
+		public:
+			MappedFile();
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			MappedFile(MappedFile&& other);
+			MappedFile& operator=(MappedFile&& other);
+
+			// closes any file already open. An empty file opens, with a nullptr data()
+			bool open(const std::string& filename);
+			void close();
+
+			bool isOpen() const;
+
+			const char* data() const;
+			std::size_t size() const;
+
+		private:
+			const char* first;
+			std::size_t count;
+			bool opened;
+
+#ifdef _WIN32
+			void* file;
+			void* mapping;
+#endif
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef DBR_CNSL_MESSAGE_QUEUE_HPP
+#define DBR_CNSL_MESSAGE_QUEUE_HPP
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			Bounded lock-free queue for many producer threads and a single consumer thread.
+			Each slot carries a sequence number telling producers and the consumer whose turn it is,
+			so producers only contend on one atomic increment, and never wait on each other.
+			(Dmitry Vyukov's bounded MPMC queue, with the consumer side simplified)
+		*/
+		template<typename T>
+		class MessageQueue
+		{
+		public:
+			// capacity is rounded up to a power of 2
+			explicit MessageQueue(std::size_t capacity);
+
+			MessageQueue(const MessageQueue&) = delete;
+			MessageQueue& operator=(const MessageQueue&) = delete;
+
+			// thread safe. Returns false without blocking if the queue is full
+			bool push(T&& value);
+
+			// like push(), but a full queue isn't counted as dropping value, so the caller can retry
+			// value is left untouched if it returns false
+			bool tryPush(T&& value);
+
+			// consumer thread only. Returns false if the queue is empty
+			bool pop(T& value);
+
+			std::size_t capacity() const;
+
+			// approximate, as producers may be pushing
+			std::size_t size() const;
+
+			std::uint64_t pushed() const;
+			std::uint64_t popped() const;
+			std::uint64_t dropped() const;
+
+		private:
+			struct Slot
+			{
+				std::atomic<std::size_t> sequence;
+				T value;
+			};
+
+			static constexpr std::size_t CACHE_LINE = 64u;
+
+			std::unique_ptr<Slot[]> slots;
+			std::size_t mask;
+
+			// kept on separate cache lines, so producers and the consumer don't invalidate each other
+			alignas(CACHE_LINE) std::atomic<std::size_t> enqueuePos;
+			alignas(CACHE_LINE) std::atomic<std::size_t> dequeuePos;
+			alignas(CACHE_LINE) std::atomic<std::uint64_t> dropCount;
+		};
+
+		template<typename T>
+		MessageQueue<T>::MessageQueue(std::size_t capacity)
+			: slots{},
+			mask{0},
+			enqueuePos{0},
+			dequeuePos{0},
+			dropCount{0}
+		{
+			std::size_t size = 2;
+			while(size < capacity)
+				size <<= 1;
+
+			slots.reset(new Slot[size]);
+			mask = size - 1;
+
+			for(auto i = 0u; i < size; ++i)
+				slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		template<typename T>
+		bool MessageQueue<T>::push(T&& value)
+		{
+			if(tryPush(std::move(value)))
+				return true;
+
+			dropCount.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		template<typename T>
+		bool MessageQueue<T>::tryPush(T&& value)
+		{
+			auto pos = enqueuePos.load(std::memory_order_relaxed);
+			Slot* slot;
+
+			for(;;)
+			{
+				slot = &slots[pos & mask];
+				auto seq = slot->sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+
+				if(diff == 0)
+				{
+					// slot is free, try to claim it
+					if(enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if(diff < 0)
+				{
+					// the consumer hasn't freed this slot yet: full
+					return false;
+				}
+				else
+				{
+					// another producer claimed it first
+					pos = enqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+
+			slot->value = std::move(value);
+			slot->sequence.store(pos + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		template<typename T>
+		bool MessageQueue<T>::pop(T& value)
+		{
+			auto pos = dequeuePos.load(std::memory_order_relaxed);
+			auto& slot = slots[pos & mask];
+			auto seq = slot.sequence.load(std::memory_order_acquire);
+
+			// not yet published by its producer
+			if(static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1) < 0)
+				return false;
+
+			value = std::move(slot.value);
+			slot.sequence.store(pos + mask + 1, std::memory_order_release);
+			dequeuePos.store(pos + 1, std::memory_order_relaxed);
+
+			return true;
+		}
+
+		template<typename T>
+		std::size_t MessageQueue<T>::capacity() const
+		{
+			return mask + 1;
+		}
+
+		template<typename T>
+		std::size_t MessageQueue<T>::size() const
+		{
+			auto in = enqueuePos.load(std::memory_order_relaxed);
+			auto out = dequeuePos.load(std::memory_order_relaxed);
+
+			return in > out ? in - out : 0;
+		}
+
+		template<typename T>
+		std::uint64_t MessageQueue<T>::pushed() const
+		{
+			return enqueuePos.load(std::memory_order_relaxed);
+		}
+
+		template<typename T>
+		std::uint64_t MessageQueue<T>::popped() const
+		{
+			return dequeuePos.load(std::memory_order_relaxed);
+		}
+
+		template<typename T>
+		std::uint64_t MessageQueue<T>::dropped() const
+		{
+			return dropCount.load(std::memory_order_relaxed);
+		}
+	}
+}
+
+#endif
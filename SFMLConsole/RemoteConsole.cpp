@@ -0,0 +1,415 @@
+#include "RemoteConsole.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <cerrno>
+
+#include <SFML/System/Utf.hpp>
+
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		namespace
+		{
+			constexpr int MAX_EVENTS = 256;			// per update(). The rest wait for the next
+			constexpr std::size_t READ_SIZE = 4096u;
+		}
+
+		RemoteConsole::RemoteConsole(ConsoleCore& console)
+			: entryLimit{DEFAULT_ENTRY_LIMIT},
+			clientLimit{DEFAULT_CLIENT_LIMIT},
+			inputLimit{DEFAULT_INPUT_LIMIT},
+			outputLimit{DEFAULT_OUTPUT_LIMIT},
+			console{console},
+			epoll{epoll_create1(EPOLL_CLOEXEC)},
+			listeners{},
+			clients{},
+			ready{}
+		{}
+
+		RemoteConsole::~RemoteConsole()
+		{
+			close();
+
+			if(epoll >= 0)
+				::close(epoll);
+		}
+
+		bool RemoteConsole::listenTcp(std::uint16_t port)
+		{
+			int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+			if(fd < 0)
+				return false;
+
+			// so a restarted server can listen again straight away
+			int reuse = 1;
+			::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+			sockaddr_in address{};
+			address.sin_family = AF_INET;
+			address.sin_port = htons(port);
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+			return listen(fd, &address, sizeof(address), {});
+		}
+
+		bool RemoteConsole::listenUnix(const std::string& path)
+		{
+			sockaddr_un address{};
+			address.sun_family = AF_UNIX;
+
+			if(path.empty() || path.size() >= sizeof(address.sun_path))
+				return false;
+
+			std::copy(path.begin(), path.end(), address.sun_path);
+
+			int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+			if(fd < 0)
+				return false;
+
+			// a socket left by an earlier run is replaced, but not one something is still listening on
+			struct stat info;
+
+			if(::lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+			{
+				int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+				bool live = probe >= 0 && ::connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+
+				if(probe >= 0)
+					::close(probe);
+
+				if(live)
+				{
+					::close(fd);
+					return false;
+				}
+
+				::unlink(path.c_str());
+			}
+
+			return listen(fd, &address, sizeof(address), path);
+		}
+
+		void RemoteConsole::close()
+		{
+			// closing a socket removes it from epoll
+			for(auto& client : clients)
+				::close(client.first);
+
+			clients.clear();
+			ready.clear();
+
+			for(auto& listener : listeners)
+			{
+				::close(listener.fd);
+
+				if(!listener.path.empty())
+					::unlink(listener.path.c_str());
+			}
+
+			listeners.clear();
+		}
+
+		void RemoteConsole::update()
+		{
+			if(epoll < 0)
+				return;
+
+			epoll_event events[MAX_EVENTS];
+			int count = epoll_wait(epoll, events, MAX_EVENTS, 0);
+
+			for(int i = 0; i < count; ++i)
+			{
+				auto fd = events[i].data.fd;
+
+				if(std::any_of(listeners.begin(), listeners.end(), [fd](const Listener& listener) { return listener.fd == fd; }))
+				{
+					accept(fd);
+					continue;
+				}
+
+				auto& client = *clients.at(fd);
+
+				// the connection is gone both ways, so nothing it sent could be answered
+				if(events[i].events & (EPOLLERR | EPOLLHUP))
+				{
+					client.closing = true;
+					continue;
+				}
+
+				if(events[i].events & EPOLLIN)
+					receive(client);
+
+				if(events[i].events & EPOLLOUT)
+					send(client);
+			}
+
+			runEntries();
+
+			std::vector<int> done;
+
+			for(auto& entry : clients)
+			{
+				auto& client = *entry.second;
+
+				// clients already waiting for their socket are sent the rest when it's writable
+				if(!client.closing && !client.writing && client.outputStart != client.output.size())
+					send(client);
+
+				if(client.closing || (client.ended && !client.queued && client.outputStart == client.output.size()))
+					done.push_back(entry.first);
+			}
+
+			for(auto fd : done)
+				disconnect(fd);
+		}
+
+		std::size_t RemoteConsole::getClientCount() const
+		{
+			return clients.size();
+		}
+
+		bool RemoteConsole::listen(int fd, const void* address, std::size_t size, const std::string& path)
+		{
+			epoll_event event{};
+			event.events = EPOLLIN;
+			event.data.fd = fd;
+
+			if(epoll < 0 || ::bind(fd, static_cast<const sockaddr*>(address), static_cast<socklen_t>(size)) != 0)
+			{
+				::close(fd);
+				return false;
+			}
+
+			if(::listen(fd, SOMAXCONN) != 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+			{
+				::close(fd);
+
+				if(!path.empty())
+					::unlink(path.c_str());
+
+				return false;
+			}
+
+			listeners.push_back({fd, path});
+			return true;
+		}
+
+		void RemoteConsole::accept(int listener)
+		{
+			while(true)
+			{
+				int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+				if(fd < 0)
+				{
+					if(errno == EINTR)
+						continue;
+
+					// none left, or out of descriptors. Either way, the rest wait for the next update()
+					break;
+				}
+
+				if(clients.size() >= clientLimit)
+				{
+					::close(fd);
+					continue;
+				}
+
+				auto client = std::make_unique<Client>();
+				client->fd = fd;
+				client->inputStart = 0;
+				client->outputStart = 0;
+				client->queued = false;
+				client->writing = false;
+				client->ended = false;
+				client->closing = false;
+
+				// the client is kept at a fixed address, so its sink can refer to it
+				auto* output = &client->output;
+				client->sink = [output](const sf::String& str)
+				{
+					sf::Utf32::toUtf8(str.begin(), str.end(), std::back_inserter(*output));
+				};
+
+				epoll_event event{};
+				event.events = EPOLLIN;
+				event.data.fd = fd;
+
+				if(epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+				{
+					::close(fd);
+					continue;
+				}
+
+				clients.emplace(fd, std::move(client));
+			}
+		}
+
+		void RemoteConsole::receive(Client& client)
+		{
+			// the socket stays readable, so anything left past inputLimit is read once entries have been run
+			while(client.input.size() - client.inputStart < inputLimit)
+			{
+				auto size = client.input.size();
+				auto space = std::min(READ_SIZE, inputLimit - (size - client.inputStart));
+
+				client.input.resize(size + space);
+				auto received = ::recv(client.fd, &client.input[size], space, 0);
+				client.input.resize(size + static_cast<std::size_t>(std::max<decltype(received)>(received, 0)));
+
+				if(received > 0)
+					continue;
+
+				if(received == 0)
+				{
+					// a last line without a newline still runs
+					if(client.input.size() != client.inputStart && client.input.back() != '\n')
+						client.input += '\n';
+
+					client.ended = true;
+					watch(client);
+				}
+				else if(errno == EINTR)
+				{
+					continue;
+				}
+				else if(errno != EAGAIN && errno != EWOULDBLOCK)
+				{
+					client.closing = true;
+				}
+
+				break;
+			}
+
+			if(client.queued)
+				return;
+
+			if(client.input.find('\n', client.inputStart) != std::string::npos)
+			{
+				ready.push_back(client.fd);
+				client.queued = true;
+			}
+			else if(client.input.size() - client.inputStart >= inputLimit)
+			{
+				// a line longer than inputLimit
+				client.closing = true;
+			}
+		}
+
+		void RemoteConsole::send(Client& client)
+		{
+			while(client.outputStart != client.output.size())
+			{
+				auto sent = ::send(client.fd, client.output.data() + client.outputStart, client.output.size() - client.outputStart, MSG_NOSIGNAL);
+
+				if(sent > 0)
+					client.outputStart += static_cast<std::size_t>(sent);
+				else if(sent < 0 && errno == EINTR)
+					continue;
+				else if(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+					break;
+				else
+				{
+					client.closing = true;
+					return;
+				}
+			}
+
+			auto pending = client.output.size() - client.outputStart;
+
+			if(pending == 0)
+			{
+				client.output.clear();
+				client.outputStart = 0;
+			}
+			else if(pending > outputLimit)
+			{
+				client.closing = true;
+				return;
+			}
+			else if(client.outputStart > pending)
+			{
+				client.output.erase(0, client.outputStart);
+				client.outputStart = 0;
+			}
+
+			if(client.writing != (pending != 0))
+			{
+				client.writing = pending != 0;
+				watch(client);
+			}
+		}
+
+		void RemoteConsole::runEntries()
+		{
+			for(std::size_t ran = 0; ran < entryLimit && !ready.empty(); ++ran)
+			{
+				auto& client = *clients.at(ready.front());
+				ready.pop_front();
+				client.queued = false;
+
+				if(client.closing)
+					continue;
+
+				auto eol = client.input.find('\n', client.inputStart);
+				auto last = eol;
+
+				if(last != client.inputStart && client.input[last - 1] == '\r')
+					--last;
+
+				auto entry = sf::String::fromUtf8(client.input.begin() + client.inputStart, client.input.begin() + last);
+				client.inputStart = eol + 1;
+
+				if(!console.run(entry, client.sink))
+					client.output += "Command does not exist\n";
+
+				// so a client always sending part of its next line doesn't grow it forever
+				if(client.inputStart > client.input.size() / 2)
+				{
+					client.input.erase(0, client.inputStart);
+					client.inputStart = 0;
+				}
+
+				// to the back, so every client with an entry runs one before this runs another
+				if(client.input.find('\n', client.inputStart) != std::string::npos)
+				{
+					ready.push_back(client.fd);
+					client.queued = true;
+				}
+			}
+		}
+
+		void RemoteConsole::watch(Client& client)
+		{
+			epoll_event event{};
+			event.data.fd = client.fd;
+
+			if(!client.ended)
+				event.events |= EPOLLIN;
+
+			if(client.writing)
+				event.events |= EPOLLOUT;
+
+			epoll_ctl(epoll, EPOLL_CTL_MOD, client.fd, &event);
+		}
+
+		void RemoteConsole::disconnect(int fd)
+		{
+			::close(fd);
+
+			ready.erase(std::remove(ready.begin(), ready.end(), fd), ready.end());
+			clients.erase(fd);
+		}
+	}
+}
@@ -0,0 +1,131 @@
+#ifndef DBR_CNSL_REMOTE_CONSOLE_HPP
+#define DBR_CNSL_REMOTE_CONSOLE_HPP
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+#include "ConsoleCore.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			Runs entries sent by clients over loopback TCP or Unix sockets on a console, for servers without a window.
+			Clients send UTF-8 lines, each run as an entry, and get back the output written while it ran
+			(see ConsoleCore::run(entry, sink)), or "Command does not exist". Other clients, and the console, don't see it.
+			Async and coroutine commands aren't run for clients, as their output would come after the entry's.
+			Everything happens in update(), on the console's thread: sockets are non-blocking and polled with epoll,
+			and a frame runs at most entryLimit entries, taking one from each client in turn, so many clients
+			sending at once share the frames fairly.
+			Anyone who can connect can run any command, so TCP only listens on 127.0.0.1, and a Unix socket is only
+			as private as its file's permissions.
+			Linux only. Built with SFMLCONSOLE_RCON, which defines DBR_CNSL_RCON
+		*/
+		class RemoteConsole
+		{
+		public:
+			explicit RemoteConsole(ConsoleCore& console);
+
+			// disconnects clients, and stops listening
+			~RemoteConsole();
+
+			RemoteConsole(const RemoteConsole&) = delete;
+			RemoteConsole& operator=(const RemoteConsole&) = delete;
+
+			// listens on 127.0.0.1:port, as well as anything already listened on. false if it can't
+			bool listenTcp(std::uint16_t port);
+
+			// listens on a Unix socket at path, replacing one left by an earlier run. Removed again by close()
+			bool listenUnix(const std::string& path);
+
+			// disconnects clients, and stops listening
+			void close();
+
+			// accepts clients, reads what they sent, runs entries, and sends output. Never blocks
+			// call once per frame, on the console's thread
+			void update();
+
+			std::size_t getClientCount() const;
+
+			/* data */
+
+			// entries run per update(), over all clients
+			std::size_t entryLimit;
+
+			// more clients than this are disconnected as soon as they're accepted
+			std::size_t clientLimit;
+
+			// bytes received from a client and not yet run. Past it, its socket isn't read until entries are run,
+			// and a line longer than it disconnects it
+			std::size_t inputLimit;
+
+			// bytes waiting to be sent to a client. A client that doesn't read its output is disconnected past it
+			std::size_t outputLimit;
+
+		private:
+			static constexpr std::size_t DEFAULT_ENTRY_LIMIT = 256u;
+			static constexpr std::size_t DEFAULT_CLIENT_LIMIT = 1024u;
+			static constexpr std::size_t DEFAULT_INPUT_LIMIT = 64u * 1024u;
+			static constexpr std::size_t DEFAULT_OUTPUT_LIMIT = 4u * 1024u * 1024u;
+
+			struct Listener
+			{
+				int fd;
+				std::string path;	// of a Unix socket, to remove when closed
+			};
+
+			struct Client
+			{
+				int fd;
+
+				std::string input;			// received. Run from inputStart on
+				std::size_t inputStart;
+				std::string output;			// UTF-8. Sent from outputStart on
+				std::size_t outputStart;
+
+				bool queued;	// in ready
+				bool writing;	// waiting for its socket to be writable
+				bool ended;		// it won't send anything more
+				bool closing;
+
+				// appends to output
+				OutputSink sink;
+			};
+
+			bool listen(int fd, const void* address, std::size_t size, const std::string& path);
+
+			void accept(int listener);
+
+			// reads until the socket is empty, or inputLimit. Queues the client if it sent a whole line
+			void receive(Client& client);
+
+			// sends as much output as the socket takes
+			void send(Client& client);
+
+			// runs one entry from each ready client in turn, until entryLimit
+			void runEntries();
+
+			// the events epoll waits on for client
+			void watch(Client& client);
+
+			void disconnect(int fd);
+
+			ConsoleCore& console;
+			int epoll;
+
+			std::vector<Listener> listeners;
+			std::unordered_map<int, std::unique_ptr<Client>> clients;
+
+			// clients with a whole line to run, in the order they get to run one
+			std::deque<int> ready;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,69 @@
+#include "StringHash.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	// odd constants from splitmix64 (prng.di.unimi.it/splitmix64.c)
+	constexpr std::uint64_t K0 = 0x9e3779b97f4a7c15u;
+	constexpr std::uint64_t K1 = 0xbf58476d1ce4e5b9u;
+	constexpr std::uint64_t K2 = 0x94d049bb133111ebu;
+
+	// two characters. memcpy, as the data is only aligned for sf::Uint32
+	std::uint64_t load(const sf::Uint32* ptr)
+	{
+		std::uint64_t word;
+		std::memcpy(&word, ptr, sizeof(word));
+		return word;
+	}
+
+	std::uint64_t mix(std::uint64_t lane, std::uint64_t word)
+	{
+		lane = (lane ^ word) * K1;
+		return lane ^ (lane >> 31);
+	}
+
+	// splitmix64's finalizer, so every input bit reaches every output bit
+	std::uint64_t finish(std::uint64_t val)
+	{
+		val = (val ^ (val >> 30)) * K1;
+		val = (val ^ (val >> 27)) * K2;
+		return val ^ (val >> 31);
+	}
+}
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		std::size_t hashString(StringView str)
+		{
+			auto* ptr = str.data();
+			auto size = str.size();
+
+			// the size is mixed in first, so strings of zeros of different lengths differ
+			std::uint64_t a = size * K0;
+			std::uint64_t b = K2;
+
+			for(; size >= 4; size -= 4, ptr += 4)
+			{
+				a = mix(a, load(ptr));
+				b = mix(b, load(ptr + 2));
+			}
+
+			if(size >= 2)
+			{
+				a = mix(a, load(ptr));
+				size -= 2;
+				ptr += 2;
+			}
+
+			if(size != 0)
+				b = mix(b, *ptr);
+
+			// truncates on 32 bit targets, after finishing, so all bits still count
+			return static_cast<std::size_t>(finish(a ^ ((b << 32) | (b >> 32))));
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef DBR_CNSL_STRING_HASH_HPP
+#define DBR_CNSL_STRING_HASH_HPP
+
+#include <cstddef>
+#include <functional>
+
+#include <SFML/System/String.hpp>
+
+#include "StringView.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			Hashes UTF-32 text two characters (one 64 bit word) at a time, in two independent lanes, so
+			compilers can keep both multiplies in flight, or vectorize them.
+			Plain C++, so it works on any architecture. Values differ between byte orders, so don't store them
+		*/
+		std::size_t hashString(StringView str);
+
+		// transparent hash and equality, for containers keyed by sf::String
+		// that can then be searched with a StringView, without copying it into a key
+		struct StringHash
+		{
+			using is_transparent = void;
+
+			std::size_t operator()(StringView str) const;
+		};
+
+		struct StringEqual
+		{
+			using is_transparent = void;
+
+			bool operator()(StringView lhs, StringView rhs) const;
+		};
+
+		inline std::size_t StringHash::operator()(StringView str) const
+		{
+			return hashString(str);
+		}
+
+		inline bool StringEqual::operator()(StringView lhs, StringView rhs) const
+		{
+			return lhs == rhs;
+		}
+	}
+}
+
+// std::hash for SFML's String class
+namespace std
+{
+	template<>
+	struct hash<sf::String>
+	{
+		std::size_t operator()(const sf::String& s) const;
+	};
+
+	inline std::size_t hash<sf::String>::operator()(const sf::String& s) const
+	{
+		return dbr::cnsl::hashString(s);
+	}
+}
+
+#endif
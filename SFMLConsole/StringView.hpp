@@ -0,0 +1,152 @@
+#ifndef DBR_CNSL_STRING_VIEW_HPP
+#define DBR_CNSL_STRING_VIEW_HPP
+
+#include <cstddef>
+
+#include <SFML/System/String.hpp>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			Non-owning view of UTF-32 characters, such as part of an sf::String.
+			Only valid as long as what it views is
+		*/
+		class StringView
+		{
+		public:
+			using const_iterator = const sf::Uint32*;
+
+			static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+			StringView();
+			StringView(const sf::Uint32* data, std::size_t size);
+
+			// views all of str
+			StringView(const sf::String& str);
+
+			const sf::Uint32* data() const;
+			std::size_t size() const;
+			bool empty() const;
+
+			const_iterator begin() const;
+			const_iterator end() const;
+
+			sf::Uint32 operator[](std::size_t idx) const;
+
+			StringView substr(std::size_t pos, std::size_t count = npos) const;
+
+			// copies the viewed characters
+			sf::String toString() const;
+
+		private:
+			const sf::Uint32* first;
+			std::size_t count;
+		};
+
+		bool operator==(StringView lhs, StringView rhs);
+		bool operator!=(StringView lhs, StringView rhs);
+
+		// rhs is compared as ASCII/Latin-1, so it can be a string literal
+		bool operator==(StringView lhs, const char* rhs);
+		bool operator!=(StringView lhs, const char* rhs);
+
+		inline StringView::StringView()
+			: first{nullptr},
+			count{0}
+		{}
+
+		inline StringView::StringView(const sf::Uint32* data, std::size_t size)
+			: first{data},
+			count{size}
+		{}
+
+		inline StringView::StringView(const sf::String& str)
+			: first{str.getData()},
+			count{str.getSize()}
+		{}
+
+		inline const sf::Uint32* StringView::data() const
+		{
+			return first;
+		}
+
+		inline std::size_t StringView::size() const
+		{
+			return count;
+		}
+
+		inline bool StringView::empty() const
+		{
+			return count == 0;
+		}
+
+		inline StringView::const_iterator StringView::begin() const
+		{
+			return first;
+		}
+
+		inline StringView::const_iterator StringView::end() const
+		{
+			return first + count;
+		}
+
+		inline sf::Uint32 StringView::operator[](std::size_t idx) const
+		{
+			return first[idx];
+		}
+
+		inline StringView StringView::substr(std::size_t pos, std::size_t count) const
+		{
+			pos = pos < this->count ? pos : this->count;
+			auto left = this->count - pos;
+
+			return{first + pos, count < left ? count : left};
+		}
+
+		inline sf::String StringView::toString() const
+		{
+			return sf::String::fromUtf32(begin(), end());
+		}
+
+		inline bool operator==(StringView lhs, StringView rhs)
+		{
+			if(lhs.size() != rhs.size())
+				return false;
+
+			for(auto i = 0u; i < lhs.size(); ++i)
+			{
+				if(lhs[i] != rhs[i])
+					return false;
+			}
+
+			return true;
+		}
+
+		inline bool operator!=(StringView lhs, StringView rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+		inline bool operator==(StringView lhs, const char* rhs)
+		{
+			auto i = 0u;
+
+			for(; i < lhs.size() && rhs[i] != 0; ++i)
+			{
+				if(lhs[i] != static_cast<unsigned char>(rhs[i]))
+					return false;
+			}
+
+			return i == lhs.size() && rhs[i] == 0;
+		}
+
+		inline bool operator!=(StringView lhs, const char* rhs)
+		{
+			return !(lhs == rhs);
+		}
+	}
+}
+
+#endif
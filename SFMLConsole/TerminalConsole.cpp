@@ -0,0 +1,661 @@
+#include "TerminalConsole.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <cerrno>
+
+#include <SFML/System/Utf.hpp>
+
+#ifdef DBR_CNSL_STATS
+#include <SFML/System/Clock.hpp>
+#endif
+
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		namespace
+		{
+			constexpr char ESC = '\x1b';
+
+			const sf::Vector2u DEFAULT_SIZE{80, 24};	// when output isn't a terminal
+
+			// {0, 0} if fd isn't a terminal
+			sf::Vector2u windowSize(int fd)
+			{
+				winsize size{};
+
+				if(::ioctl(fd, TIOCGWINSZ, &size) != 0 || size.ws_col == 0 || size.ws_row == 0)
+					return {0, 0};
+
+				return {size.ws_col, size.ws_row};
+			}
+
+			sf::Vector2u initialSize(int fd)
+			{
+				auto size = windowSize(fd);
+
+				return size.x != 0 ? size : DEFAULT_SIZE;
+			}
+
+			void appendNumber(std::string& str, std::size_t n)
+			{
+				char digits[20];
+				auto* end = digits + sizeof(digits);
+				auto* first = end;
+
+				do
+				{
+					*--first = static_cast<char>('0' + n % 10);
+					n /= 10;
+				}
+				while(n != 0);
+
+				str.append(first, end);
+			}
+
+			// as few write()s as fd takes it in. false if it failed part way
+			bool writeAll(int fd, const std::string& str)
+			{
+				for(std::size_t written = 0; written < str.size();)
+				{
+					auto n = ::write(fd, str.data() + written, str.size() - written);
+
+					if(n > 0)
+						written += static_cast<std::size_t>(n);
+					else if(n < 0 && errno == EINTR)
+						continue;
+					else
+						return false;
+				}
+
+				return true;
+			}
+		}
+
+		TerminalConsole::TerminalConsole(const sf::String& prompt, int inputFd, int outputFd)
+			: ConsoleCore{initialSize(outputFd), prompt},
+			inputFd{inputFd},
+			outputFd{outputFd},
+			saved{nullptr},
+			open{true},
+			pending{},
+			sinceInput{},
+			palette{},
+			shownRows{},
+			shown{},
+			shownSize{0, 0},
+			screenDirty{},
+			cursorX{0},
+			cursorY{0},
+			attribute{0},
+			cursorVisible{true},
+			frame{},
+			frameBytes{0}
+		{
+			// keys as they're typed, without echo, and Ctrl+C as a character, so it cancels commands
+			// rather than the server
+			termios raw;
+
+			if(::isatty(inputFd) && ::tcgetattr(inputFd, &raw) == 0)
+			{
+				saved = std::make_unique<termios>(raw);
+
+				raw.c_iflag &= ~static_cast<tcflag_t>(ICRNL | IXON | BRKINT | INPCK | ISTRIP);
+				raw.c_lflag &= ~static_cast<tcflag_t>(ICANON | ECHO | ISIG | IEXTEN);
+				raw.c_cc[VMIN] = 0;
+				raw.c_cc[VTIME] = 0;
+
+				::tcsetattr(inputFd, TCSANOW, &raw);
+			}
+
+			// the alternate screen, so the shell's output is still there afterwards
+			if(::isatty(outputFd))
+				writeAll(outputFd, "\x1b[?1049h");
+		}
+
+		TerminalConsole::~TerminalConsole()
+		{
+			if(::isatty(outputFd))
+				writeAll(outputFd, "\x1b[0m\x1b[?25h\x1b[?1049l");
+
+			if(saved)
+				::tcsetattr(inputFd, TCSANOW, saved.get());
+		}
+
+		void TerminalConsole::poll()
+		{
+			// an ioctl a frame, rather than a SIGWINCH handler, which would be the whole process's
+			auto size = windowSize(outputFd);
+
+			if(size.x != 0 && size != getSize())
+				setSize(size);
+
+			bool received = false;
+
+			while(open)
+			{
+				pollfd fd{inputFd, POLLIN, 0};
+
+				if(::poll(&fd, 1, 0) <= 0 || !(fd.revents & (POLLIN | POLLHUP)))
+					break;
+
+				auto start = pending.size();
+				pending.resize(start + READ_SIZE);
+				auto read = ::read(inputFd, &pending[start], READ_SIZE);
+				pending.resize(start + static_cast<std::size_t>(std::max<decltype(read)>(read, 0)));
+
+				if(read > 0)
+				{
+					received = true;
+					parseInput();
+				}
+				else if(read == 0)
+				{
+					// a last line without a newline still runs
+					if(getEditor().getSize() != 0)
+						input('\r');
+
+					open = false;
+				}
+				else if(errno != EINTR)
+				{
+					break;
+				}
+			}
+
+			// a lone Escape, or the start of a sequence that never finished. Told apart from one still arriving by the wait
+			if(received)
+				sinceInput.restart();
+			else if(!pending.empty() && sinceInput.getElapsedTime().asMilliseconds() >= ESCAPE_TIMEOUT)
+				pending.clear();
+		}
+
+		void TerminalConsole::draw()
+		{
+#ifdef DBR_CNSL_STATS
+			sf::Clock clock;
+			std::size_t cells = 0;
+#endif
+
+			auto& grid = getGrid();
+			auto& size = grid.getSize();
+
+			frame.clear();
+
+			// the first draw(), a new size, or invalidate(): start from a blank screen
+			if(shownSize != size)
+			{
+				shownSize = size;
+				shownRows.assign(size.y, NO_ROW);
+				shown.assign(size.x * size.y, {' ', 0});
+
+				frame += "\x1b[0m\x1b[?25l\x1b[2J";
+				attribute = 0;
+				cursorX = size.x + 1;
+				cursorVisible = false;
+			}
+
+			scrollRows();
+
+			// changed cells only matter if their row is on screen
+			auto top = grid.viewTop();
+			auto rows = grid.getScrollbackSize();
+
+			for(auto& d : grid.getDirty())
+			{
+				for(auto first = d.first; first < d.last;)
+				{
+					auto row = first / size.x;
+					auto last = std::min(d.last, (row + 1) * size.x);
+					auto y = (row + rows - top) % rows;
+
+					if(y < size.y && shownRows[y] == row)
+						TextGrid::addSpan(screenDirty, y * size.x + first % size.x, last - first);
+
+					first = last;
+				}
+			}
+
+			grid.clearDirty();
+
+			std::size_t lineY = NO_ROW;
+			std::size_t lineEnd = 0;	// of lineY's text. Blanks past it are erased to the end of the row in one escape
+
+			for(auto& d : screenDirty)
+			{
+				for(auto i = d.first; i < d.last; ++i)
+				{
+					auto x = i % size.x;
+					auto y = i / size.x;
+					auto* row = grid.getRow(shownRows[y]);
+					auto cell = shownCell(row[x]);
+
+					if(cell.codePoint == shown[i].codePoint && cell.attribute == shown[i].attribute)
+						continue;
+
+					if(y != lineY)
+					{
+						lineY = y;
+						lineEnd = size.x;
+
+						while(lineEnd != 0 && shownCell(row[lineEnd - 1]).codePoint == ' ')
+							--lineEnd;
+					}
+
+					if(x >= lineEnd)
+					{
+						emitMove(x, y);
+						frame += "\x1b[K";
+
+						auto rowEnd = shown.begin() + static_cast<std::ptrdiff_t>((y + 1) * size.x);
+						std::fill(shown.begin() + static_cast<std::ptrdiff_t>(i), rowEnd, Cell{' ', 0});
+						i = (y + 1) * size.x - 1;
+					}
+					else
+					{
+						emitCell(i, cell);
+						shown[i] = cell;
+					}
+
+#ifdef DBR_CNSL_STATS
+					++cells;
+#endif
+				}
+			}
+
+			screenDirty.clear();
+
+			// no cursor while scrolled back, as the entry isn't in view
+			auto cursor = grid.getCursor();
+			bool showCursor = grid.getScrollOffset() == 0 && cursor < size.x * size.y;
+
+			if(showCursor)
+				emitMove(cursor % size.x, cursor / size.x);
+
+			if(showCursor != cursorVisible)
+			{
+				frame += showCursor ? "\x1b[?25h" : "\x1b[?25l";
+				cursorVisible = showCursor;
+			}
+
+			flush();
+
+#ifdef DBR_CNSL_STATS
+			// cells written stand in for vertices
+			recordDraw(clock.getElapsedTime(), cells);
+#endif
+		}
+
+		void TerminalConsole::invalidate()
+		{
+			shownSize = {0, 0};
+		}
+
+		void TerminalConsole::setTextColor(sf::Uint8 r, sf::Uint8 g, sf::Uint8 b)
+		{
+			std::string color;
+			appendNumber(color, r);
+			color += ';';
+			appendNumber(color, g);
+			color += ';';
+			appendNumber(color, b);
+
+			auto it = std::find(palette.begin(), palette.end(), color);
+
+			if(it != palette.end())
+			{
+				getGrid().setAttribute(static_cast<sf::Uint32>(it - palette.begin()) + 1);
+			}
+			else if(palette.size() < MAX_COLORS)
+			{
+				palette.push_back(std::move(color));
+				getGrid().setAttribute(static_cast<sf::Uint32>(palette.size()));
+			}
+			else
+			{
+				getGrid().setAttribute(0);
+			}
+		}
+
+		void TerminalConsole::resetTextColor()
+		{
+			getGrid().setAttribute(0);
+		}
+
+		bool TerminalConsole::isOpen() const
+		{
+			return open;
+		}
+
+		std::size_t TerminalConsole::getFrameBytes() const
+		{
+			return frameBytes;
+		}
+
+		void TerminalConsole::parseInput()
+		{
+			std::size_t i = 0;
+
+			while(i < pending.size() && open)
+			{
+				auto c = static_cast<unsigned char>(pending[i]);
+
+				if(c == ESC)
+				{
+					auto length = parseEscape(pending, i);
+
+					if(length == 0)
+						break;
+
+					i += length;
+				}
+				else if(c >= 0x80)
+				{
+					// UTF-8, decoded once all its bytes have arrived
+					std::size_t length = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : 2;
+
+					if(pending.size() - i < length)
+						break;
+
+					sf::Uint32 unicode;
+					auto* begin = pending.data() + i;
+					i += static_cast<std::size_t>(sf::Utf8::decode(begin, begin + length, unicode, 0xFFFD) - begin);
+
+					input(unicode);
+				}
+				else
+				{
+					++i;
+
+					switch(c)
+					{
+						// Backspace sends DEL on most terminals
+						case 0x7F:
+						case '\b':
+							input('\b');
+							break;
+
+						// Ctrl+D ends the session, as it would a shell, if nothing has been typed
+						case 0x04:
+							if(getEditor().getSize() == 0)
+								open = false;
+							break;
+
+						// Ctrl+L redraws the screen
+						case 0x0C:
+							invalidate();
+							break;
+
+						default:
+							input(c);
+							break;
+					}
+				}
+			}
+
+			pending.erase(0, i);
+		}
+
+		std::size_t TerminalConsole::parseEscape(const std::string& str, std::size_t start)
+		{
+			auto left = str.size() - start;
+
+			if(left < 2)
+				return 0;
+
+			auto kind = str[start + 1];
+
+			// ESC O x, sent for arrows, Home and End in the terminal's application mode
+			if(kind == 'O')
+			{
+				if(left < 3)
+					return 0;
+
+				switch(str[start + 2])
+				{
+					case 'A': input(Key::Up); break;
+					case 'B': input(Key::Down); break;
+					case 'C': input(Key::Right); break;
+					case 'D': input(Key::Left); break;
+					case 'H': input(Key::Home); break;
+					case 'F': input(Key::End); break;
+					default: break;
+				}
+
+				return 3;
+			}
+
+			// Alt+key. The key is typed without it
+			if(kind != '[')
+				return 1;
+
+			// ESC [ parameters final, where final is in @ to ~. Parameters (as in 1;5 for Ctrl) are ignored,
+			// apart from the first, which picks the key of a ~ sequence
+			std::size_t end = start + 2;
+			std::size_t number = 0;
+			bool first = true;
+
+			while(end < str.size() && (str[end] < 0x40 || str[end] > 0x7E))
+			{
+				if(str[end] == ';')
+					first = false;
+				else if(first && str[end] >= '0' && str[end] <= '9')
+					number = std::min<std::size_t>(number * 10 + static_cast<std::size_t>(str[end] - '0'), 1000);
+
+				++end;
+			}
+
+			if(end == str.size())
+				return left > MAX_ESCAPE ? left : 0;
+
+			switch(str[end])
+			{
+				case 'A': input(Key::Up); break;
+				case 'B': input(Key::Down); break;
+				case 'C': input(Key::Right); break;
+				case 'D': input(Key::Left); break;
+				case 'H': input(Key::Home); break;
+				case 'F': input(Key::End); break;
+
+				case '~':
+					switch(number)
+					{
+						case 1:
+						case 7:
+							input(Key::Home);
+							break;
+
+						case 4:
+						case 8:
+							input(Key::End);
+							break;
+
+						case 3: input(Key::Delete); break;
+						case 5: input(Key::PageUp); break;
+						case 6: input(Key::PageDown); break;
+						default: break;
+					}
+					break;
+
+				default:
+					break;
+			}
+
+			return end + 1 - start;
+		}
+
+		void TerminalConsole::scrollRows()
+		{
+			auto& grid = getGrid();
+			auto& size = grid.getSize();
+
+			auto top = grid.viewTop();
+			auto rows = grid.getScrollbackSize();
+
+			// the terminal scrolls the shown cells with it, so they stay a copy of what it shows
+			if(shownRows[0] != NO_ROW && shownRows[0] != top)
+			{
+				auto up = (top + rows - shownRows[0]) % rows;	// new output, or scrolling towards it
+				auto down = rows - up;							// scrolling back
+
+				auto width = static_cast<std::ptrdiff_t>(size.x);
+				auto cells = static_cast<std::ptrdiff_t>(shown.size());
+
+				if(up <= down && up < size.y)
+				{
+					frame += ESC;
+					frame += '[';
+					appendNumber(frame, up);
+					frame += 'S';
+
+					auto shift = static_cast<std::ptrdiff_t>(up) * width;
+					std::move(shown.begin() + shift, shown.end(), shown.begin());
+					std::fill(shown.end() - shift, shown.end(), Cell{' ', 0});
+
+					std::move(shownRows.begin() + static_cast<std::ptrdiff_t>(up), shownRows.end(), shownRows.begin());
+					std::fill(shownRows.end() - static_cast<std::ptrdiff_t>(up), shownRows.end(), NO_ROW);
+				}
+				else if(down < size.y)
+				{
+					frame += ESC;
+					frame += '[';
+					appendNumber(frame, down);
+					frame += 'T';
+
+					auto shift = static_cast<std::ptrdiff_t>(down) * width;
+					std::move_backward(shown.begin(), shown.begin() + (cells - shift), shown.end());
+					std::fill(shown.begin(), shown.begin() + shift, Cell{' ', 0});
+
+					std::move_backward(shownRows.begin(), shownRows.end() - static_cast<std::ptrdiff_t>(down), shownRows.end());
+					std::fill(shownRows.begin(), shownRows.begin() + static_cast<std::ptrdiff_t>(down), NO_ROW);
+				}
+			}
+
+			for(auto y = 0u; y < size.y; ++y)
+			{
+				auto row = (top + y) % rows;
+
+				if(shownRows[y] != row)
+				{
+					shownRows[y] = row;
+					TextGrid::addSpan(screenDirty, y * size.x, size.x);
+				}
+			}
+		}
+
+		TerminalConsole::Cell TerminalConsole::shownCell(const Cell& cell) const
+		{
+			if(cell.codePoint == TextGrid::EMPTY_CELL || cell.codePoint == ' ')
+				return {' ', 0};
+
+			// control characters would move the terminal's cursor
+			auto codePoint = cell.codePoint < 0x20 || (cell.codePoint >= 0x7F && cell.codePoint < 0xA0) ? '?' : cell.codePoint;
+
+			return {codePoint, cell.attribute <= palette.size() ? cell.attribute : 0};
+		}
+
+		void TerminalConsole::emitCell(std::size_t screenIdx, const Cell& cell)
+		{
+			auto width = getGrid().getSize().x;
+
+			emitMove(screenIdx % width, screenIdx / width);
+
+			// blanks look the same in any color
+			if(cell.codePoint != ' ' && cell.attribute != attribute)
+				emitAttribute(cell.attribute);
+
+			if(cell.codePoint < 0x80)
+			{
+				frame += static_cast<char>(cell.codePoint);
+				++cursorX;
+			}
+			else
+			{
+				// the terminal may draw it 2 columns wide, or wrap it onto the next row, so where the cursor ends up isn't known
+				sf::Utf8::encode(cell.codePoint, std::back_inserter(frame), '?');
+				cursorX = width + 1;
+			}
+		}
+
+		void TerminalConsole::emitAttribute(sf::Uint32 attribute)
+		{
+			if(attribute == 0)
+			{
+				frame += "\x1b[39m";
+			}
+			else
+			{
+				frame += "\x1b[38;2;";
+				frame += palette[attribute - 1];
+				frame += 'm';
+			}
+
+			this->attribute = attribute;
+		}
+
+		void TerminalConsole::emitMove(std::size_t x, std::size_t y)
+		{
+			auto width = getGrid().getSize().x;
+
+			if(y == cursorY && x == cursorX)
+				return;
+
+			// the shortest way there: a few cells written again as they are, forward along the row,
+			// the start of the next row, or anywhere
+			if(y == cursorY && x > cursorX && cursorX < width)
+			{
+				auto first = shown.begin() + static_cast<std::ptrdiff_t>(y * width + cursorX);
+				auto last = first + static_cast<std::ptrdiff_t>(x - cursorX);
+
+				bool rewrite = x - cursorX < MAX_REWRITE && std::all_of(first, last, [this](const Cell& cell)
+				{
+					return cell.codePoint < 0x80 && (cell.codePoint == ' ' || cell.attribute == attribute);
+				});
+
+				if(rewrite)
+				{
+					for(; first != last; ++first)
+						frame += static_cast<char>(first->codePoint);
+				}
+				else
+				{
+					frame += ESC;
+					frame += '[';
+					appendNumber(frame, x - cursorX);
+					frame += 'C';
+				}
+			}
+			else if(y == cursorY + 1 && x == 0 && cursorX <= width)
+			{
+				frame += "\r\n";
+			}
+			else
+			{
+				frame += ESC;
+				frame += '[';
+				appendNumber(frame, y + 1);
+				frame += ';';
+				appendNumber(frame, x + 1);
+				frame += 'H';
+			}
+
+			cursorX = x;
+			cursorY = y;
+		}
+
+		void TerminalConsole::flush()
+		{
+			frameBytes = frame.size();
+
+			// the terminal shows part of the frame at best
+			if(!writeAll(outputFd, frame))
+				invalidate();
+		}
+	}
+}
@@ -0,0 +1,142 @@
+#ifndef DBR_CNSL_TERMINAL_CONSOLE_HPP
+#define DBR_CNSL_TERMINAL_CONSOLE_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/String.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include "ConsoleCore.hpp"
+
+// forward declarations
+struct termios;
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			Draws a ConsoleCore to a terminal with ANSI escapes, and feeds it the keys typed there. For servers without a
+			window or GL context, so operators at the terminal use the same commands and output as players in game.
+			draw() only writes the cells that changed since the last draw(), in a single write(). Visible rows moving
+			up or down (new output, or scrolling the view) are moved by scrolling the terminal, rather than rewritten,
+			and rows emptied past their text are erased with one escape.
+			Cells are taken to be one column wide, as they are in the grid. Wider characters may overlap the cell after them.
+			While it exists the terminal is in raw mode on its alternate screen, as a full screen editor would put it.
+			Unix only. Built with SFMLCONSOLE_TERMINAL, which defines DBR_CNSL_TERMINAL
+		*/
+		class TerminalConsole : public ConsoleCore
+		{
+		public:
+			// sized to the terminal outputFd is, or 80 x 24 if it isn't one
+			TerminalConsole(const sf::String& prompt, int inputFd = 0, int outputFd = 1);
+
+			// puts the terminal back as it was
+			~TerminalConsole();
+
+			TerminalConsole(const TerminalConsole&) = delete;
+			TerminalConsole& operator=(const TerminalConsole&) = delete;
+
+			/* actions */
+
+			using ConsoleCore::update;
+
+			// reads the keys typed since the last call, and follows the terminal's size. Never blocks
+			void poll();
+
+			// writes the cells that changed since the last draw(), and places the cursor
+			void draw();
+
+			// redraws every cell on the next draw(). For when something else wrote to the terminal
+			void invalidate();
+
+			// output written after this is drawn in the 24 bit color r, g, b, instead of the terminal's own
+			// up to 256 distinct colors can be used. Past that, output falls back to the terminal's
+			void setTextColor(sf::Uint8 r, sf::Uint8 g, sf::Uint8 b);
+			void resetTextColor();
+
+			/* properties functions */
+
+			// false once input has ended: Ctrl+D with an empty entry, or the end of a piped input
+			bool isOpen() const;
+
+			// bytes written by the last draw(). 0 if nothing changed
+			std::size_t getFrameBytes() const;
+
+		private:
+			using Cell = TextGrid::Cell;
+			using Span = TextGrid::Span;
+
+			static constexpr std::size_t NO_ROW = static_cast<std::size_t>(-1);
+			static constexpr sf::Uint32 NO_ATTRIBUTE = static_cast<sf::Uint32>(-1);
+			static constexpr std::size_t READ_SIZE = 256u;
+			static constexpr std::size_t MAX_ESCAPE = 32u;		// bytes. A longer unfinished sequence is dropped
+			static constexpr sf::Int32 ESCAPE_TIMEOUT = 50;		// ms without more input before an unfinished sequence is dropped
+			static constexpr std::size_t MAX_COLORS = 256u;		// setTextColor() searches the palette
+			static constexpr std::size_t MAX_REWRITE = 4u;		// cells skipped by writing them again, rather than moving the cursor
+
+			// feeds the console the characters and escape sequences in pending, leaving an incomplete one
+			void parseInput();
+
+			// bytes of the escape sequence at the start of str, handled if it's a key. 0 if it's incomplete
+			std::size_t parseEscape(const std::string& str, std::size_t start);
+
+			// scrolls the terminal, if the grid's visible rows are still on it, but moved up or down
+			// rows then showing something else are compared in full
+			void scrollRows();
+
+			// a cell as the terminal draws it: spaces for empty cells, and unknown attributes as 0
+			Cell shownCell(const Cell& cell) const;
+
+			// appends escapes for what differs from the terminal's cursor and attribute, then the cell's character
+			void emitCell(std::size_t screenIdx, const Cell& cell);
+			void emitAttribute(sf::Uint32 attribute);
+			void emitMove(std::size_t x, std::size_t y);
+
+			// writes all of frame
+			void flush();
+
+			int inputFd;
+			int outputFd;
+
+			// the terminal's settings before raw mode, restored when destroyed. Empty if input isn't a terminal
+			std::unique_ptr<::termios> saved;
+
+			bool open;
+
+			// read, but not yet a whole character or escape sequence
+			std::string pending;
+
+			// since input was last read. A sequence's rest can come a few frames later, over ssh
+			sf::Clock sinceInput;
+
+			// colors of attributes past 0, as "r;g;b"
+			std::vector<std::string> palette;
+
+			// what the terminal shows: the ring row on each of its rows, and its cells
+			std::vector<std::size_t> shownRows;
+			std::vector<Cell> shown;
+			sf::Vector2u shownSize;
+
+			// screen cells to compare with shown
+			std::vector<Span> screenDirty;
+
+			// the terminal's cursor and attribute as the escapes in frame leave them
+			// a cursorX of size.x is past the end of the row, and past that is unknown
+			std::size_t cursorX;
+			std::size_t cursorY;
+			sf::Uint32 attribute;
+			bool cursorVisible;
+
+			// everything a draw() writes
+			std::string frame;
+			std::size_t frameBytes;
+		};
+	}
+}
+
+#endif
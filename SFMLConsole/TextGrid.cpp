@@ -0,0 +1,463 @@
+#include "TextGrid.hpp"
+
+#include <algorithm>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		TextGrid::TextGrid(sf::Vector2u size, std::size_t scrollbackRows)
+			: size{size},
+			cells{},
+			scrollbackRows{std::max<std::size_t>((scrollbackRows + size.y - 1) / size.y, 1) * size.y},
+			requestedRows{scrollbackRows},
+			rowWidths{},
+			rowWrapped{},
+			spareCells{},
+			spareWidths{},
+			spareWrapped{},
+			headRow{0},
+			usedRows{size.y},
+			scrollOffset{0},
+			lineFeeds{0},
+			cursorIndex{0},
+			attribute{0},
+			dirty{}
+		{
+			cells.assign(this->scrollbackRows * size.x, Cell{EMPTY_CELL, 0});
+			rowWidths.assign(this->scrollbackRows, 0);
+			rowWrapped.assign(this->scrollbackRows, false);
+
+			markDirty(0, cells.size());
+		}
+
+		void TextGrid::write(const sf::String& str)
+		{
+			write(StringView{str});
+		}
+
+		void TextGrid::write(StringView str)
+		{
+			const auto screenSize = size.x * size.y;
+
+			auto it = str.begin();
+			const auto end = str.end();
+
+			while(it != end)
+			{
+				bool wrapped;
+
+				if(*it == '\n')
+				{
+					cursorIndex = nextLine();
+					wrapped = false;
+					++it;
+				}
+				else
+				{
+					// write the run of characters up to the end of this line or row
+					auto col = cursorIndex % size.x;
+					auto start = col;
+					auto ring = ringRow(cursorIndex);
+					auto* row = &cells[ring * size.x];
+					auto written = rowWidths[ring];
+
+					for(; it != end && *it != '\n' && col < size.x; ++it, ++col)
+					{
+						// don't mess with spaces
+						if(*it != ' ')
+						{
+							row[col] = {*it, attribute};
+							written = std::max(written, col + 1);
+						}
+					}
+
+					rowWidths[ring] = written;
+					markDirty(ring * size.x + start, col - start);
+					cursorIndex += col - cursorIndex % size.x;
+					wrapped = col == size.x;
+				}
+
+				if(cursorIndex >= screenSize)
+				{
+					lineFeed();
+					cursorIndex -= size.x;
+				}
+
+				// moved to the start of a row, by a newline or by filling the row
+				if(cursorIndex % size.x == 0)
+					rowWrapped[ringRow(cursorIndex)] = wrapped;
+			}
+
+			setCursor(cursorIndex);
+		}
+
+		void TextGrid::put(sf::Uint32 unicode)
+		{
+			if(unicode == '\n')
+			{
+				newLine();
+			}
+			else
+			{
+				// don't mess with spaces
+				if(unicode != ' ')
+				{
+					cellAt(cursorIndex) = {unicode, attribute};
+
+					auto& width = rowWidths[ringRow(cursorIndex)];
+					width = std::max(width, cursorIndex % size.x + 1);
+				}
+
+				setCursor(cursorIndex + 1);
+
+				if(cursorIndex % size.x == 0)
+					rowWrapped[ringRow(cursorIndex)] = true;
+			}
+		}
+
+		void TextGrid::erase(std::size_t count)
+		{
+			for(auto i = 0u; i < count; ++i)
+				cellAt(cursorIndex + i) = {EMPTY_CELL, 0};
+		}
+
+		void TextGrid::newLine()
+		{
+			setCursor(nextLine());
+			rowWrapped[ringRow(cursorIndex)] = false;
+		}
+
+		void TextGrid::set(std::size_t idx, sf::Uint32 unicode)
+		{
+			if(unicode == ' ' || unicode == EMPTY_CELL)
+			{
+				cellAt(idx) = {EMPTY_CELL, 0};
+			}
+			else
+			{
+				cellAt(idx) = {unicode, attribute};
+
+				auto& width = rowWidths[ringRow(idx)];
+				width = std::max(width, idx % size.x + 1);
+			}
+		}
+
+		void TextGrid::clear()
+		{
+			std::fill(cells.begin(), cells.end(), Cell{EMPTY_CELL, 0});
+			std::fill(rowWidths.begin(), rowWidths.end(), 0);
+			std::fill(rowWrapped.begin(), rowWrapped.end(), false);
+
+			markDirty(0, cells.size());
+
+			headRow = 0;
+			usedRows = size.y;
+			scrollOffset = 0;
+
+			setCursor(0);
+		}
+
+		void TextGrid::scroll(int rows)
+		{
+			auto maxOffset = static_cast<long>(usedRows - size.y);
+			auto offset = static_cast<long>(scrollOffset) + rows;
+
+			scrollOffset = static_cast<std::size_t>(std::max(0l, std::min(offset, maxOffset)));
+		}
+
+		std::size_t TextGrid::getCursor() const
+		{
+			return cursorIndex;
+		}
+
+		void TextGrid::setCursor(std::size_t idx)
+		{
+			while(idx >= size.x * size.y)
+			{
+				lineFeed();
+				idx -= size.x;
+			}
+
+			cursorIndex = idx;
+		}
+
+		std::size_t TextGrid::nextLine() const
+		{
+			return cursorIndex + size.x - cursorIndex % size.x;
+		}
+
+		sf::Uint32 TextGrid::getAttribute() const
+		{
+			return attribute;
+		}
+
+		void TextGrid::setAttribute(sf::Uint32 attribute)
+		{
+			this->attribute = attribute;
+		}
+
+		const sf::Vector2u& TextGrid::getSize() const
+		{
+			return size;
+		}
+
+		void TextGrid::resize(sf::Vector2u newSize)
+		{
+			newSize.x = std::max(newSize.x, 1u);
+			newSize.y = std::max(newSize.y, 1u);
+
+			if(newSize == size)
+				return;
+
+			const std::size_t oldWidth = size.x;
+			const std::size_t newWidth = newSize.x;
+
+			// rows are numbered from the oldest stored, up to the cursor's
+			auto stored = usedRows - size.y;
+			auto oldest = (headRow + scrollbackRows - stored) % scrollbackRows;
+			auto count = stored + cursorIndex / oldWidth + 1;
+			auto viewRow = stored - scrollOffset;
+			auto ring = [&](std::size_t row) { return (oldest + row) % scrollbackRows; };
+
+			// the last line ends at the cursor
+			auto cursorCol = cursorIndex % oldWidth;
+
+			// calls f(first, last, length, rows) for each line: its rows [first, last), and length and rows once rewrapped
+			auto forEachLine = [&](auto&& f)
+			{
+				for(std::size_t first = 0; first < count;)
+				{
+					auto last = first + 1;
+
+					while(last < count && rowWrapped[ring(last)])
+						++last;
+
+					std::size_t length;
+					std::size_t rows;
+
+					if(last == count)
+					{
+						length = (last - 1 - first) * oldWidth + cursorCol;
+						rows = length / newWidth + 1;
+					}
+					else
+					{
+						length = (last - 1 - first) * oldWidth + rowWidths[ring(last - 1)];
+						rows = std::max<std::size_t>((length + newWidth - 1) / newWidth, 1);
+					}
+
+					f(first, last, length, rows);
+					first = last;
+				}
+			};
+
+			std::size_t total = 0;
+			forEachLine([&](std::size_t, std::size_t, std::size_t, std::size_t rows) { total += rows; });
+
+			auto newRows = std::max<std::size_t>((requestedRows + newSize.y - 1) / newSize.y, 1) * newSize.y;
+
+			// the oldest rows that don't fit are dropped
+			auto excess = total > newRows ? total - newRows : 0;
+			auto kept = total - excess;
+
+			// cells past each row's width are emptied as the rows are filled, so the whole buffer is only written once
+			spareCells.resize(newRows * newWidth);
+			spareWidths.assign(newRows, 0);
+			spareWrapped.assign(newRows, false);
+
+			std::size_t out = 0;	// new row the line starts on, counting dropped rows
+			std::size_t newView = 0;
+			std::size_t newCursorCol = 0;
+
+			forEachLine([&](std::size_t first, std::size_t last, std::size_t length, std::size_t rows)
+			{
+				if(first <= viewRow && viewRow < last)
+					newView = out + (viewRow - first) * oldWidth / newWidth;
+
+				if(last == count)
+					newCursorCol = length % newWidth;
+
+				if(out + rows > excess)
+				{
+					for(auto row = first; row < last; ++row)
+					{
+						auto offset = (row - first) * oldWidth;
+						auto* src = &cells[ring(row) * oldWidth];
+						auto n = std::min(row + 1 < last ? oldWidth : rowWidths[ring(row)], length - offset);
+
+						while(n != 0)
+						{
+							auto dst = out + offset / newWidth;
+							auto col = offset % newWidth;
+							auto take = std::min(n, newWidth - col);
+
+							if(dst >= excess)
+							{
+								std::copy(src, src + take, &spareCells[(dst - excess) * newWidth + col]);
+								spareWidths[dst - excess] = col + take;
+							}
+
+							src += take;
+							offset += take;
+							n -= take;
+						}
+					}
+
+					for(auto row = std::max(out, excess); row < out + rows; ++row)
+					{
+						auto* cells = &spareCells[(row - excess) * newWidth];
+						std::fill(cells + spareWidths[row - excess], cells + newWidth, Cell{EMPTY_CELL, 0});
+
+						spareWrapped[row - excess] = row != out;
+					}
+				}
+
+				out += rows;
+			});
+
+			std::fill(spareCells.begin() + kept * newWidth, spareCells.end(), Cell{EMPTY_CELL, 0});
+
+			// the cursor's row is the last row kept, at the bottom of the screen once there is enough output to fill it
+			auto head = kept > newSize.y ? kept - newSize.y : 0;
+
+			cells.swap(spareCells);
+			rowWidths.swap(spareWidths);
+			rowWrapped.swap(spareWrapped);
+
+			size = newSize;
+			scrollbackRows = newRows;
+			headRow = head;
+			usedRows = head + size.y;
+			scrollOffset = scrollOffset == 0 ? 0 : head - std::min(head, newView > excess ? newView - excess : 0);
+			cursorIndex = (kept - 1 - head) * newWidth + newCursorCol;
+
+			dirty.clear();
+			markDirty(0, cells.size());
+		}
+
+		std::size_t TextGrid::getScrollbackSize() const
+		{
+			return scrollbackRows;
+		}
+
+		void TextGrid::setScrollbackSize(std::size_t rows)
+		{
+			scrollbackRows = std::max<std::size_t>((rows + size.y - 1) / size.y, 1) * size.y;
+			requestedRows = rows;
+
+			cells.assign(scrollbackRows * size.x, Cell{EMPTY_CELL, 0});
+			rowWidths.assign(scrollbackRows, 0);
+			rowWrapped.assign(scrollbackRows, false);
+
+			clear();
+		}
+
+		std::size_t TextGrid::getScrollOffset() const
+		{
+			return scrollOffset;
+		}
+
+		std::uint64_t TextGrid::getLineFeeds() const
+		{
+			return lineFeeds;
+		}
+
+		std::size_t TextGrid::viewTop() const
+		{
+			return (headRow + scrollbackRows - scrollOffset) % scrollbackRows;
+		}
+
+		const TextGrid::Cell* TextGrid::getRow(std::size_t ringRow) const
+		{
+			return &cells[ringRow * size.x];
+		}
+
+		const std::vector<TextGrid::Span>& TextGrid::getDirty() const
+		{
+			return dirty;
+		}
+
+		void TextGrid::clearDirty() const
+		{
+			dirty.clear();
+		}
+
+		std::size_t TextGrid::getMemoryUsage() const
+		{
+			return (cells.capacity() + spareCells.capacity()) * sizeof(Cell)
+				+ (rowWidths.capacity() + spareWidths.capacity()) * sizeof(std::size_t)
+				+ (rowWrapped.capacity() + spareWrapped.capacity()) / 8;
+		}
+
+		void TextGrid::addSpan(std::vector<Span>& spans, std::size_t first, std::size_t count)
+		{
+			if(count == 0)
+				return;
+
+			Span span{first, first + count};
+
+			// writes are mostly sequential, so usually this just extends the last span
+			if(!spans.empty() && span.first <= spans.back().last && spans.back().first <= span.last)
+			{
+				spans.back().first = std::min(spans.back().first, span.first);
+				spans.back().last = std::max(spans.back().last, span.last);
+			}
+			else if(spans.size() < MAX_DIRTY_SPANS)
+			{
+				spans.push_back(span);
+			}
+			else
+			{
+				for(auto& s : spans)
+				{
+					span.first = std::min(span.first, s.first);
+					span.last = std::max(span.last, s.last);
+				}
+
+				spans.assign(1, span);
+			}
+		}
+
+		std::size_t TextGrid::ringRow(std::size_t screenIdx) const
+		{
+			return (headRow + screenIdx / size.x) % scrollbackRows;
+		}
+
+		TextGrid::Cell& TextGrid::cellAt(std::size_t screenIdx)
+		{
+			auto idx = ringRow(screenIdx) * size.x + screenIdx % size.x;
+			markDirty(idx, 1);
+
+			return cells[idx];
+		}
+
+		void TextGrid::markDirty(std::size_t first, std::size_t count)
+		{
+			addSpan(dirty, first, count);
+		}
+
+		void TextGrid::lineFeed()
+		{
+			headRow = (headRow + 1) % scrollbackRows;
+			++lineFeeds;
+
+			if(usedRows < scrollbackRows)
+				++usedRows;
+
+			// keep a scrolled back view on the same output, as long as it is still stored
+			if(scrollOffset != 0)
+				scroll(1);
+
+			// the new bottom row reuses the oldest row in the ring
+			auto bottom = (headRow + size.y - 1) % scrollbackRows;
+			auto* row = &cells[bottom * size.x];
+
+			std::fill(row, row + rowWidths[bottom], Cell{EMPTY_CELL, 0});
+
+			markDirty(bottom * size.x, rowWidths[bottom]);
+			rowWidths[bottom] = 0;
+			rowWrapped[bottom] = false;
+		}
+	}
+}
@@ -0,0 +1,166 @@
+#ifndef DBR_CNSL_TEXT_GRID_HPP
+#define DBR_CNSL_TEXT_GRID_HPP
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <SFML/System/String.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include "StringView.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			Console output, without any rendering.
+			A screen of size.x by size.y cells, written at a cursor, on top of a ring buffer of scrollback rows.
+			Scrolling the output only moves the ring's head, so no cells are ever copied.
+			Rows remember if a line wrapped onto them, so resize() can wrap the output again at a new width.
+			Renderers read the rows in view with viewTop()/getRow(), and what changed with getDirty()
+		*/
+		class TextGrid
+		{
+		public:
+			// positions and sizes are fixed by the grid, so a cell only stores what is drawn in it
+			struct Cell
+			{
+				sf::Uint32 codePoint;	// EMPTY_CELL if nothing is drawn
+				sf::Uint32 attribute;	// meaning is up to the renderer (Console uses it as a color index)
+			};
+
+			// range of cells changed since the last clearDirty()
+			struct Span
+			{
+				std::size_t first;
+				std::size_t last;	// one past the end
+			};
+
+			static constexpr sf::Uint32 EMPTY_CELL = 0u;
+
+			// scrollbackRows is rounded up to a multiple of size.y
+			TextGrid(sf::Vector2u size, std::size_t scrollbackRows);
+
+			// writes str a row at a time, and only updates the cursor once at the end
+			void write(const sf::String& str);
+			void write(StringView str);
+			void put(sf::Uint32 unicode);
+
+			// empties count cells starting at the cursor, without moving it
+			void erase(std::size_t count);
+
+			// ends the line at the cursor, moving the cursor to the start of the next row. Same as writing '\n'
+			void newLine();
+
+			// writes one cell on the visible screen, without moving the cursor
+			// spaces and EMPTY_CELL empty the cell
+			void set(std::size_t idx, sf::Uint32 unicode);
+
+			void clear();
+
+			// moves the view by rows into the scrollback (positive is towards older output)
+			void scroll(int rows);
+
+			// index on the visible screen
+			std::size_t getCursor() const;
+
+			// moving past the bottom of the screen scrolls the output up
+			void setCursor(std::size_t idx);
+
+			// screen index of the start of the row below the cursor
+			std::size_t nextLine() const;
+
+			// attribute of cells written from now on
+			sf::Uint32 getAttribute() const;
+			void setAttribute(sf::Uint32 attribute);
+
+			const sf::Vector2u& getSize() const;
+
+			// rewraps the output to size.x columns, keeping the scrollback's rows (rounded up to a multiple of size.y),
+			// and the newest output if it no longer fits. The cursor stays after the same character, and output
+			// after it is dropped. The view stays on the same output if it was scrolled back
+			// the old buffers are kept for the next resize, so resizing repeatedly doesn't allocate
+			void resize(sf::Vector2u size);
+
+			// number of rows kept, including the visible rows. Rounded up to a multiple of size.y
+			// (so a renderer can keep ring row r in slot r % size.y). Changing it clears the grid
+			std::size_t getScrollbackSize() const;
+			void setScrollbackSize(std::size_t rows);
+
+			// rows the view is scrolled back from the live screen
+			std::size_t getScrollOffset() const;
+
+			// rows the screen has scrolled up by since the grid was made. A screen index taken
+			// when this was n is (getLineFeeds() - n) * size.x lower now
+			std::uint64_t getLineFeeds() const;
+
+			// ring row at the top of the view
+			std::size_t viewTop() const;
+
+			// the size.x cells of a ring row
+			const Cell* getRow(std::size_t ringRow) const;
+
+			// cells, by index in the ring, changed since the last clearDirty()
+			const std::vector<Span>& getDirty() const;
+
+			// dirty spans are a renderer's bookkeeping, so clearing them doesn't count as changing the grid
+			void clearDirty() const;
+
+			// bytes held by the cells, their row bookkeeping, and resize()'s spare buffers
+			std::size_t getMemoryUsage() const;
+
+			// records count cells from first in spans, merging with the last span if they touch
+			static void addSpan(std::vector<Span>& spans, std::size_t first, std::size_t count);
+
+		private:
+			// maps an index on the visible screen to its row/cell in the ring
+			// cellAt() marks the cell dirty, so only use it for writing
+			std::size_t ringRow(std::size_t screenIdx) const;
+			Cell& cellAt(std::size_t screenIdx);
+
+			void markDirty(std::size_t first, std::size_t count);
+
+			// advances the screen by one row, recycling the oldest row of the ring
+			void lineFeed();
+
+			static constexpr std::size_t MAX_DIRTY_SPANS = 16u;	// past this, spans are merged into one
+
+			sf::Vector2u size;
+
+			// a ring buffer of scrollbackRows rows of size.x cells
+			std::vector<Cell> cells;
+
+			std::size_t scrollbackRows;
+			std::size_t requestedRows;	// before rounding, so resizes don't round it up again and again
+
+			// per ring row, one past the last cell written. Lets lineFeed() skip never written cells
+			std::vector<std::size_t> rowWidths;
+
+			// per ring row, true if the line on the row above wrapped onto it, rather than ending
+			std::vector<bool> rowWrapped;
+
+			// the buffers from before the last resize(), swapped in and refilled by the next one
+			std::vector<Cell> spareCells;
+			std::vector<std::size_t> spareWidths;
+			std::vector<bool> spareWrapped;
+
+			// ring index of the top row of the live screen
+			std::size_t headRow;
+
+			// rows holding output, including the live screen
+			std::size_t usedRows;
+
+			std::size_t scrollOffset;
+			std::uint64_t lineFeeds;
+
+			std::size_t cursorIndex;
+			sf::Uint32 attribute;
+
+			mutable std::vector<Span> dirty;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include "Tokenizer.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		ArgsView::ArgsView()
+			: first{nullptr},
+			count{0}
+		{}
+
+		ArgsView::ArgsView(const StringView* args, std::size_t count)
+			: first{args},
+			count{count}
+		{}
+
+		std::size_t ArgsView::size() const
+		{
+			return count;
+		}
+
+		bool ArgsView::empty() const
+		{
+			return count == 0;
+		}
+
+		ArgsView::const_iterator ArgsView::begin() const
+		{
+			return first;
+		}
+
+		ArgsView::const_iterator ArgsView::end() const
+		{
+			return first + count;
+		}
+
+		StringView ArgsView::operator[](std::size_t idx) const
+		{
+			return first[idx];
+		}
+
+		StringView ArgsView::front() const
+		{
+			return first[0];
+		}
+
+		Args ArgsView::toArgs() const
+		{
+			Args args;
+			args.reserve(count);
+
+			for(auto arg : *this)
+				args.push_back(arg.toString());
+
+			return args;
+		}
+
+		ArgsView Tokenizer::tokenize(StringView entry)
+		{
+			tokens.clear();
+			scratch.clear();
+
+			// unescaping never makes an argument longer, so all of them fit in the entry's size
+			if(scratch.capacity() < entry.size())
+				scratch.reserve(entry.size());
+
+			auto it = entry.begin();
+			const auto end = entry.end();
+
+			auto isQuote = [](sf::Uint32 c) { return c == '"' || c == '\''; };
+
+			for(;;)
+			{
+				while(it != end && isSpace(*it))
+					++it;
+
+				if(it == end)
+					break;
+
+				auto start = it;
+
+				// plain word
+				while(it != end && !isSpace(*it) && !isQuote(*it) && *it != '\\')
+					++it;
+
+				if(it == end || isSpace(*it))
+				{
+					tokens.emplace_back(start, it - start);
+					continue;
+				}
+
+				// a whole quoted argument, without escapes
+				if(it == start && isQuote(*it))
+				{
+					auto quote = *it;
+					auto close = it + 1;
+
+					while(close != end && *close != quote && (quote == '\'' || *close != '\\'))
+						++close;
+
+					if(close != end && *close == quote && (close + 1 == end || isSpace(close[1])))
+					{
+						tokens.emplace_back(it + 1, close - it - 1);
+						it = close + 1;
+						continue;
+					}
+				}
+
+				// anything else is unescaped into scratch
+				auto first = scratch.size();
+				scratch.insert(scratch.end(), start, it);
+
+				sf::Uint32 quote = 0;
+
+				for(; it != end; ++it)
+				{
+					auto c = *it;
+
+					if(quote == 0 && isSpace(c))
+						break;
+
+					if(quote != 0 && c == quote)
+						quote = 0;
+					else if(quote == 0 && isQuote(c))
+						quote = c;
+					else if(c == '\\' && quote != '\'' && it + 1 != end)
+						scratch.push_back(*++it);
+					else
+						scratch.push_back(c);
+				}
+
+				tokens.emplace_back(scratch.data() + first, scratch.size() - first);
+			}
+
+			return{tokens.data(), tokens.size()};
+		}
+
+		bool Tokenizer::isSpace(sf::Uint32 c)
+		{
+			return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#ifndef DBR_CNSL_TOKENIZER_HPP
+#define DBR_CNSL_TOKENIZER_HPP
+
+#include <vector>
+#include <cstddef>
+
+#include <SFML/System/String.hpp>
+
+#include "StringView.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		using Args = std::vector<sf::String>;
+
+		// arguments of a command, as views into its entry. Only valid during the command's call
+		class ArgsView
+		{
+		public:
+			using const_iterator = const StringView*;
+
+			ArgsView();
+			ArgsView(const StringView* args, std::size_t count);
+
+			std::size_t size() const;
+			bool empty() const;
+
+			const_iterator begin() const;
+			const_iterator end() const;
+
+			StringView operator[](std::size_t idx) const;
+			StringView front() const;
+
+			// copies the arguments, for keeping them past the call
+			Args toArgs() const;
+
+		private:
+			const StringView* first;
+			std::size_t count;
+		};
+
+		/*
+			Splits an entry into arguments separated by runs of whitespace, without allocating once its storage has grown.
+			"double" or 'single' quotes keep whitespace in an argument. A backslash escapes the next character,
+			except in single quotes, where everything is literal. Quoted and unquoted parts next to each other join up.
+			Arguments are views into the entry when possible. The rest are unescaped into storage kept by the tokenizer
+		*/
+		class Tokenizer
+		{
+		public:
+			Tokenizer() = default;
+
+			// the returned views are valid until the next tokenize(), and while entry is
+			ArgsView tokenize(StringView entry);
+
+			static bool isSpace(sf::Uint32 c);
+
+		private:
+			std::vector<StringView> tokens;
+
+			// unescaped arguments. Reserved up front to the entry's size, so it never reallocates under the views
+			std::vector<sf::Uint32> scratch;
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include "TypedCommand.hpp"
+
+#include <iterator>
+
+#include <SFML/System/Utf.hpp>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		namespace
+		{
+			std::string toUtf8(StringView str)
+			{
+				std::string utf8;
+				sf::Utf32::toUtf8(str.begin(), str.end(), std::back_inserter(utf8));
+
+				return utf8;
+			}
+
+			template<typename T>
+			bool parseFloat(StringView arg, T& value)
+			{
+				// room for any float written out in full is far more than any typed, so long ones just don't parse
+				char buffer[64];
+
+				if(!toChars(arg, buffer, sizeof(buffer)))
+					return false;
+
+				const char* first = buffer;
+				const char* last = buffer + arg.size();
+
+				// from_chars doesn't take a +
+				if(*first == '+')
+					++first;
+
+				if(first == last || (*first == '-' && first != buffer))
+					return false;
+
+				auto result = std::from_chars(first, last, value);
+
+				return result.ec == std::errc{} && result.ptr == last;
+			}
+		}
+
+		bool parseArg(StringView arg, bool& value)
+		{
+			if(arg == "true" || arg == "on" || arg == "yes" || arg == "1")
+				value = true;
+			else if(arg == "false" || arg == "off" || arg == "no" || arg == "0")
+				value = false;
+			else
+				return false;
+
+			return true;
+		}
+
+		bool parseArg(StringView arg, float& value)
+		{
+			return parseFloat(arg, value);
+		}
+
+		bool parseArg(StringView arg, double& value)
+		{
+			return parseFloat(arg, value);
+		}
+
+		bool parseArg(StringView arg, StringView& value)
+		{
+			value = arg;
+			return true;
+		}
+
+		bool parseArg(StringView arg, sf::String& value)
+		{
+			value = arg.toString();
+			return true;
+		}
+
+		bool parseArg(StringView arg, std::string& value)
+		{
+			value = toUtf8(arg);
+			return true;
+		}
+
+		bool toChars(StringView arg, char* buffer, std::size_t size)
+		{
+			if(arg.empty() || arg.size() >= size)
+				return false;
+
+			for(auto c : arg)
+			{
+				if(c > 0x7f)
+					return false;
+
+				*buffer++ = static_cast<char>(c);
+			}
+
+			*buffer = '\0';
+
+			return true;
+		}
+
+		UsageError usageError(StringView name, const std::string& problem, const std::string& params)
+		{
+			auto utf8Name = toUtf8(name);
+
+			return UsageError{utf8Name + ": " + problem + "\nusage: " + utf8Name + params};
+		}
+
+		UsageError argumentError(StringView name, std::size_t idx, const char* expected, StringView arg, const std::string& params)
+		{
+			return usageError(name, "argument " + std::to_string(idx) + ": expected " + expected + ", got \"" + toUtf8(arg) + '"', params);
+		}
+	}
+}
@@ -0,0 +1,292 @@
+#ifndef DBR_CNSL_TYPED_COMMAND_HPP
+#define DBR_CNSL_TYPED_COMMAND_HPP
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <tuple>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+#include <cstddef>
+#include <limits>
+
+#include <SFML/System/String.hpp>
+
+#include "StringView.hpp"
+#include "Tokenizer.hpp"
+#include "CommandRegistry.hpp"
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			Commands with typed parameters, like void(int, float, StringView), added with ConsoleCore::addCommand().
+			The parameters are read from the callable's signature at compile time, and each argument is parsed straight
+			from its token, numbers with std::from_chars. So running one doesn't allocate, unless it takes an sf::String,
+			std::string, or std::string_view, which are (or view) copies of their token.
+			A wrong number of arguments, or one that doesn't parse, throws UsageError instead of calling the command
+		*/
+
+		// what was wrong with a typed command's arguments, and its usage. ConsoleCore::run() prints it
+		class UsageError : public std::invalid_argument
+		{
+		public:
+			using std::invalid_argument::invalid_argument;
+		};
+
+		// parses arg into value. false if it isn't one
+		// bools are true/false, on/off, yes/no, or 1/0
+		bool parseArg(StringView arg, bool& value);
+		bool parseArg(StringView arg, float& value);
+		bool parseArg(StringView arg, double& value);
+		bool parseArg(StringView arg, StringView& value);
+		bool parseArg(StringView arg, sf::String& value);
+		bool parseArg(StringView arg, std::string& value);	// as UTF-8
+
+		// decimal, or hexadecimal after 0x, with an optional sign. Out of range values don't parse
+		template<typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+		bool parseArg(StringView arg, T& value);
+
+		// copies arg into buffer, null terminated, if it is all ASCII and fits. Lets std::from_chars parse it
+		bool toChars(StringView arg, char* buffer, std::size_t size);
+
+		// "name: problem\nusage: name params"
+		UsageError usageError(StringView name, const std::string& problem, const std::string& params);
+
+		// usageError() for the argument at index idx (from 1), that isn't an expected
+		UsageError argumentError(StringView name, std::size_t idx, const char* expected, StringView arg, const std::string& params);
+
+		// how a parameter is shown in a usage message
+		template<typename T>
+		constexpr const char* argName()
+		{
+			if constexpr(std::is_same_v<T, bool>)
+				return "bool";
+			else if constexpr(std::is_integral_v<T>)
+				return std::is_signed_v<T> ? "int" : "uint";
+			else if constexpr(std::is_floating_point_v<T>)
+				return "number";
+			else
+				return "string";
+		}
+
+		// what a parameter's argument is parsed into. Tokens are UTF-32, so a std::string_view views a UTF-8 copy
+		template<typename T>
+		struct ArgStorage
+		{
+			using Type = T;
+		};
+
+		template<>
+		struct ArgStorage<std::string_view>
+		{
+			using Type = std::string;
+		};
+
+		template<typename T>
+		using ArgStorageT = typename ArgStorage<T>::Type;
+
+		// T has a parseArg()
+		template<typename T, typename = void>
+		struct IsArg : std::false_type {};
+
+		template<typename T>
+		struct IsArg<T, std::void_t<decltype(parseArg(std::declval<StringView>(), std::declval<ArgStorageT<T>&>()))>> : std::true_type {};
+
+		// the result and (decayed) parameters of a function pointer, or a callable with one, non-template operator()
+		template<typename F, typename = void>
+		struct Signature
+		{
+			static constexpr bool known = false;
+		};
+
+		template<typename R, typename... A>
+		struct Signature<R(*)(A...), void>
+		{
+			static constexpr bool known = true;
+			using Result = R;
+			using Params = std::tuple<std::decay_t<A>...>;
+		};
+
+		template<typename C, typename R, typename... A>
+		struct Signature<R(C::*)(A...), void> : Signature<R(*)(A...)> {};
+
+		template<typename C, typename R, typename... A>
+		struct Signature<R(C::*)(A...) const, void> : Signature<R(*)(A...)> {};
+
+		template<typename F>
+		struct Signature<F, std::void_t<decltype(&F::operator())>> : Signature<decltype(&F::operator())> {};
+
+		template<typename Params>
+		struct AreArgs;
+
+		template<typename... A>
+		struct AreArgs<std::tuple<A...>> : std::bool_constant<(IsArg<A>::value && ...)> {};
+
+		template<typename F, typename = void>
+		struct IsTypedCommand : std::false_type {};
+
+		template<typename F>
+		struct IsTypedCommand<F, std::enable_if_t<Signature<F>::known>>
+			: std::bool_constant<std::is_void_v<typename Signature<F>::Result> && AreArgs<typename Signature<F>::Params>::value> {};
+
+		// F returns void, and every parameter has a parseArg()
+		template<typename F>
+		constexpr bool isTypedCommand = IsTypedCommand<std::decay_t<F>>::value;
+
+		template<typename F, typename Params>
+		class TypedCommand;
+
+		// calls F with its arguments parsed from an ArgsView
+		template<typename F, typename... A>
+		class TypedCommand<F, std::tuple<A...>>
+		{
+		public:
+			explicit TypedCommand(F command);
+
+			// args.front() is the command's name
+			void operator()(ArgsView args);
+
+		private:
+			template<std::size_t... I>
+			void call(ArgsView args, std::index_sequence<I...>);
+
+			// " <int> <number> ..."
+			static std::string params();
+
+			F command;
+		};
+
+		// command, taking an ArgsView
+		template<typename F>
+		CommandView makeTypedCommand(F&& command);
+
+		template<typename F, typename... A>
+		TypedCommand<F, std::tuple<A...>>::TypedCommand(F command)
+			: command{std::move(command)}
+		{}
+
+		template<typename F, typename... A>
+		void TypedCommand<F, std::tuple<A...>>::operator()(ArgsView args)
+		{
+			constexpr auto count = sizeof...(A);
+
+			if(args.size() != count + 1)
+				throw usageError(args.front(), "expected " + std::to_string(count) + (count == 1 ? " argument, got " : " arguments, got ") + std::to_string(args.size() - 1), params());
+
+			call(args, std::index_sequence_for<A...>{});
+		}
+
+		template<typename F, typename... A>
+		template<std::size_t... I>
+		void TypedCommand<F, std::tuple<A...>>::call([[maybe_unused]] ArgsView args, std::index_sequence<I...>)
+		{
+			std::tuple<ArgStorageT<A>...> values;
+
+			// a command without parameters has nothing to parse, or to name
+			if constexpr(sizeof...(A) != 0)
+			{
+				std::size_t bad = 0;
+
+				// in order, stopping at the first that doesn't parse
+				bool parsed = ((parseArg(args[I + 1], std::get<I>(values)) || (bad = I + 1, false)) && ...);
+
+				if(!parsed)
+				{
+					const char* names[] = {argName<A>()...};
+					throw argumentError(args.front(), bad, names[bad - 1], args[bad], params());
+				}
+			}
+
+			std::apply(command, std::move(values));
+		}
+
+		template<typename F, typename... A>
+		std::string TypedCommand<F, std::tuple<A...>>::params()
+		{
+			std::string names;
+			((names += " <", names += argName<A>(), names += '>'), ...);
+
+			return names;
+		}
+
+		template<typename F>
+		CommandView makeTypedCommand(F&& command)
+		{
+			using Callable = std::decay_t<F>;
+
+			return TypedCommand<Callable, typename Signature<Callable>::Params>{std::forward<F>(command)};
+		}
+
+		template<typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int>>
+		bool parseArg(StringView arg, T& value)
+		{
+			// the longest 64 bit number, with a sign and 0x, fits
+			char buffer[32];
+
+			if(!toChars(arg, buffer, sizeof(buffer)))
+				return false;
+
+			const char* first = buffer;
+			const char* last = buffer + arg.size();
+
+			// from_chars takes neither a + nor a base prefix, so the sign is applied to the parsed magnitude
+			bool negative = *first == '-';
+
+			if(negative || *first == '+')
+				++first;
+
+			int base = 10;
+
+			if(last - first > 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X'))
+			{
+				base = 16;
+				first += 2;
+			}
+
+			using Magnitude = std::make_unsigned_t<T>;
+
+			// from_chars would take a second -
+			if(first == last || *first == '-')
+				return false;
+
+			Magnitude magnitude;
+			auto result = std::from_chars(first, last, magnitude, base);
+
+			if(result.ec != std::errc{} || result.ptr != last)
+				return false;
+
+			constexpr auto max = static_cast<Magnitude>(std::numeric_limits<T>::max());
+
+			if(!negative)
+			{
+				if(magnitude > max)
+					return false;
+
+				value = static_cast<T>(magnitude);
+			}
+			else if(magnitude == 0)
+			{
+				value = 0;
+			}
+			else if constexpr(std::is_signed_v<T>)
+			{
+				// the most negative value's magnitude is one more than the max
+				if(magnitude - 1 > max)
+					return false;
+
+				value = static_cast<T>(-static_cast<T>(magnitude - 1) - 1);
+			}
+			else
+			{
+				return false;
+			}
+
+			return true;
+		}
+	}
+}
+
+#endif
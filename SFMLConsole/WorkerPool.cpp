@@ -0,0 +1,70 @@
+#include "WorkerPool.hpp"
+
+#include <utility>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		WorkerPool::WorkerPool(std::size_t threads)
+			: threads{},
+			tasks{},
+			mutex{},
+			ready{},
+			stopping{false}
+		{
+			for(auto i = 0u; i < threads || i == 0; ++i)
+				this->threads.emplace_back(&WorkerPool::work, this);
+		}
+
+		WorkerPool::~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock{mutex};
+				stopping = true;
+			}
+
+			ready.notify_all();
+
+			for(auto& t : threads)
+				t.join();
+		}
+
+		void WorkerPool::push(std::function<void()>&& task)
+		{
+			{
+				std::lock_guard<std::mutex> lock{mutex};
+				tasks.push_back(std::move(task));
+			}
+
+			ready.notify_one();
+		}
+
+		std::size_t WorkerPool::getThreadCount() const
+		{
+			return threads.size();
+		}
+
+		void WorkerPool::work()
+		{
+			for(;;)
+			{
+				std::function<void()> task;
+
+				{
+					std::unique_lock<std::mutex> lock{mutex};
+					ready.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+					// queued tasks still run after stopping, so no job is left unfinished
+					if(tasks.empty())
+						return;
+
+					task = std::move(tasks.front());
+					tasks.pop_front();
+				}
+
+				task();
+			}
+		}
+	}
+}
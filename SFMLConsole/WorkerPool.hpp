@@ -0,0 +1,47 @@
+#ifndef DBR_CNSL_WORKER_POOL_HPP
+#define DBR_CNSL_WORKER_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+
+namespace dbr
+{
+	namespace cnsl
+	{
+		/*
+			A fixed set of threads running tasks in the order they were pushed.
+			Destroying the pool waits for the queued tasks to run, then joins the threads
+		*/
+		class WorkerPool
+		{
+		public:
+			explicit WorkerPool(std::size_t threads);
+			~WorkerPool();
+
+			WorkerPool(const WorkerPool&) = delete;
+			WorkerPool& operator=(const WorkerPool&) = delete;
+
+			// thread safe
+			void push(std::function<void()>&& task);
+
+			std::size_t getThreadCount() const;
+
+		private:
+			void work();
+
+			std::vector<std::thread> threads;
+
+			std::deque<std::function<void()>> tasks;
+			std::mutex mutex;
+			std::condition_variable ready;
+			bool stopping;
+		};
+	}
+}
+
+#endif
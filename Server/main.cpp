@@ -0,0 +1,67 @@
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <chrono>
+
+#include "TerminalConsole.hpp"
+
+#ifdef DBR_CNSL_RCON
+#include "RemoteConsole.hpp"
+#endif
+
+// a dedicated server's console: no window or GL context, just the terminal it was started in
+// Ctrl+D, or "quit", exits
+int main([[maybe_unused]] int argc, [[maybe_unused]] char** argv)
+{
+	using namespace dbr;
+
+	cnsl::TerminalConsole console{"> "};
+	bool running = true;
+
+	console.addCommand("quit", [&running]()
+	{
+		running = false;
+	});
+
+	// its arguments are parsed to the parameters' types. "color 300 0 0" prints its usage instead
+	console.addCommand("color", [&console](sf::Uint8 r, sf::Uint8 g, sf::Uint8 b)
+	{
+		console.setTextColor(r, g, b);
+	});
+
+	// "tickrate 20", "list"... Kept between runs in server.cfg
+	auto tickRate = console.addCVar<unsigned>("tickrate", 60, "frames per second, 1 to 1000");
+
+	console.loadCVars("server.cfg");
+
+#ifdef DBR_CNSL_RCON
+	// with --rcon, "nc localhost 27015" runs the same commands, from another terminal or a script
+	cnsl::RemoteConsole rcon{console};
+
+	if(argc > 1 && std::string{argv[1]} == "--rcon" && !rcon.listenTcp(27015))
+		console.post("Couldn't listen on port 27015\n");
+#endif
+
+	// posted, so it's printed above the prompt by the first update()
+	console.post("Server started. Tab completes commands, \"list\" lists variables\n");
+
+	while(running && console.isOpen())
+	{
+		console.poll();
+		console.update();
+
+#ifdef DBR_CNSL_RCON
+		rcon.update();
+#endif
+
+		// only the cells that changed are written, so an idle frame writes nothing
+		console.draw();
+
+		auto rate = std::min(std::max(tickRate.get(), 1u), 1000u);
+		std::this_thread::sleep_for(std::chrono::microseconds{1000000 / rate});
+	}
+
+	console.saveCVars("server.cfg");
+
+	return 0;
+}
@@ -1,4 +1,7 @@
 #include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
 
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Window/Event.hpp>
@@ -6,20 +9,96 @@
 #include "Console.hpp"
 #include "BitmapFont.hpp"
 
+#ifdef DBR_CNSL_RCON
+#include "RemoteConsole.hpp"
+#endif
+
+// generated from res/font12.png by FontCompiler at build time, so the font needs no file
+#if __has_include("Font12.hpp")
+#include "Font12.hpp"
+#define HAS_EMBEDDED_FONT12
+#endif
+
 int main(int argc, char** argv)
 {
 	using namespace dbr;
 
 	sfml::BitmapFont monoFont;
+#ifdef HAS_EMBEDDED_FONT12
+	monoFont.loadFromCompiled(fonts::font12, sizeof(fonts::font12));
+#else
 	monoFont.loadFromFile("res/font12.png", {12, 12});
+#endif
+
+	// run with --ttf <file> to rasterize glyphs from a TrueType/OpenType font as they are needed instead
+	sf::Font trueType;
+
+	if(argc > 2 && std::string{argv[1]} == "--ttf" && trueType.loadFromFile(argv[2]))
+		monoFont.loadFromFont(trueType, 16);
 
 	cnsl::Console console{monoFont};
 	console.setPosition(30, 30);
 
+	// run with LIBGL_ALWAYS_SOFTWARE=1 to check the shader renderer without a GPU
+	if(argc > 1 && std::string{argv[1]} == "--shader")
+		console.setRenderMode(cnsl::Console::RenderMode::Shader);
+
+	// runs on a worker thread, so the window stays responsive while it counts. Ctrl+C stops it
+	console.addCommand("count", [](const cnsl::Args&, cnsl::Job& job)
+	{
+		for(auto i = 0; i < 100 && !job.isCancelled(); ++i)
+		{
+			job.post(std::to_string(i) + '\n');
+			std::this_thread::sleep_for(std::chrono::milliseconds{50});
+		}
+	});
+
+	// its arguments are parsed to the parameters' types. "color 300 0 0" prints its usage instead
+	console.addCommand("color", [&console](sf::Uint8 r, sf::Uint8 g, sf::Uint8 b)
+	{
+		console.setTextColor({r, g, b});
+	});
+
+#ifdef DBR_CNSL_COROUTINES
+	// runs on the main thread, but spread over frames, a millisecond at a time
+	console.addCommand("fill", [&console](cnsl::Args) -> cnsl::FrameTask
+	{
+		for(auto i = 0; i < 5000; ++i)
+		{
+			console << i << ' ';
+			co_await cnsl::budget(sf::milliseconds(1));
+		}
+
+		console << '\n';
+	});
+#endif
+
+#ifdef DBR_CNSL_RCON
+	// with --rcon, "nc localhost 27015" runs commands here, and gets their output back
+	cnsl::RemoteConsole rcon{console};
+
+	if(argc > 1 && std::string{argv[1]} == "--rcon" && !rcon.listenTcp(27015))
+		std::cerr << "Couldn't listen on port 27015\n";
+#endif
+
 	sf::RenderWindow window{{1280, 720}, "SFML Console"};
 
+	// "fps 30", "set vsync on", "list"... Kept between runs in console.cfg
+	auto fps = console.addCVar<unsigned>("fps", 60, "frame rate limit, 0 for none");
+	auto vsync = console.addCVar("vsync", false, "sync frames to the display");
+
+	fps.onChange([&window](unsigned limit) { window.setFramerateLimit(limit); });
+	vsync.onChange([&window](bool enabled) { window.setVerticalSyncEnabled(enabled); });
+
+	console.loadCVars("console.cfg");
+
+	window.setFramerateLimit(fps.get());
+	window.setVerticalSyncEnabled(vsync.get());
+
 	while(window.isOpen())
 	{
+		bool resized = false;
+
 		sf::Event event;
 		while(window.pollEvent(event))
 		{
@@ -34,6 +113,10 @@ int main(int argc, char** argv)
 						window.close();
 					break;
 
+				case sf::Event::Resized:
+					resized = true;
+					break;
+
 				default:
 					break;
 			}
@@ -41,10 +124,27 @@ int main(int argc, char** argv)
 			console.update(event);
 		}
 
+		// the console fills the window, rewrapping its output once per frame however many resize events there were
+		if(resized)
+		{
+			auto size = static_cast<sf::Vector2f>(window.getSize());
+
+			window.setView(sf::View{{0.f, 0.f, size.x, size.y}});
+			console.setPixelSize(size - 2.f * console.getPosition());
+		}
+
+		console.update();
+
+#ifdef DBR_CNSL_RCON
+		rcon.update();
+#endif
+
 		window.clear();
 		window.draw(console);
 		window.display();
 	}
 
+	console.saveCVars("console.cfg");
+
 	return 0;
 }
\ No newline at end of file